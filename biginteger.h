@@ -1,27 +1,424 @@
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cctype>
+#include <climits>
+#include <cmath>
 #include <compare>
 #include <cstring>
+#include <future>
 #include <iostream>
+#include <limits>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define BIGINTEGER_X86_SIMD 1
+#endif
+
 class BigInteger {
+  public:
+    // Vector add and subtract kernels are picked at runtime from what the
+    // CPU supports; simd_level caps the choice, kScalar turns them off.
+    enum class SimdLevel {
+        kScalar,
+        kAvx2,
+        kAvx512,
+    };
+    static SimdLevel simd_level;
+
+    // Values (and so Rationals) created on this thread while the scope is
+    // alive keep their limbs in the given allocator, such as a StackAllocator
+    // over a StackStorage, so a whole computation runs in one arena. A moved
+    // value takes its buffer along, so a result that outlives the scope has
+    // to be copy-assigned to a value from outside; values holding buffers of
+    // the scope must be destroyed before it ends. Only the thread that opened
+    // the scope uses the allocator: parallel multiplication runs inline
+    // while a scope is open. Scopes nest.
+    template <typename Allocator>
+    class ArenaScope;
+
   private:
+    // An ArenaScope with its allocator erased.
+    struct LimbArena {
+        long long* (*allocate)(void*, size_t);
+        void (*deallocate)(void*, long long*, size_t);
+        void* allocator;
+        LimbArena* outer;
+    };
+    // The innermost ArenaScope of the thread.
+    static thread_local LimbArena* limb_arena_;
+
+    static constexpr LimbArena* current_arena() {
+        return std::is_constant_evaluated() ? nullptr : limb_arena_;
+    }
+
+    // Limb storage with room for kInlineLimbs_ limbs inside the object, so
+    // values below kBase_^kInlineLimbs_ never touch the heap. There is no
+    // pointer into the object itself, which keeps it usable in constant
+    // expressions; a value evaluated at compile time may persist only while
+    // it is inline. The buffer comes from the arena that was current when
+    // the storage was created, or from the heap.
+    class Limbs {
+        static constexpr size_t kInlineLimbs_ = 2;
+
+        long long* heap_ = nullptr;
+        LimbArena* arena_ = current_arena();
+        size_t size_ = 0;
+        size_t capacity_ = kInlineLimbs_;
+        long long inline_[kInlineLimbs_] = {};
+
+        constexpr void release() {
+            if (arena_ != nullptr && heap_ != nullptr) {
+                arena_->deallocate(arena_->allocator, heap_, capacity_);
+            } else {
+                delete[] heap_;
+            }
+            heap_ = nullptr;
+            capacity_ = kInlineLimbs_;
+        }
+
+        // Takes the buffer of other together with its arena.
+        constexpr void steal(Limbs& other) {
+            arena_ = other.arena_;
+            if (other.heap_ == nullptr) {
+                std::copy(other.begin(), other.end(), inline_);
+            } else {
+                heap_ = other.heap_;
+                capacity_ = other.capacity_;
+                other.heap_ = nullptr;
+                other.capacity_ = kInlineLimbs_;
+            }
+            size_ = other.size_;
+            other.size_ = 0;
+        }
+
+      public:
+        Limbs() = default;
+
+        constexpr Limbs(size_t count, long long value) {
+            assign(count, value);
+        }
+
+        constexpr Limbs(const Limbs& other) {
+            assign(other.begin(), other.end());
+        }
+
+        constexpr Limbs(Limbs&& other) noexcept {
+            steal(other);
+        }
+
+        constexpr Limbs& operator=(const Limbs& other) {
+            if (this != &other) {
+                assign(other.begin(), other.end());
+            }
+            return *this;
+        }
+
+        constexpr Limbs& operator=(Limbs&& other) noexcept {
+            if (this == &other) {
+                return *this;
+            }
+            release();
+            steal(other);
+            return *this;
+        }
+
+        constexpr ~Limbs() {
+            release();
+        }
+
+        constexpr size_t size() const {
+            return size_;
+        }
+        constexpr bool empty() const {
+            return size_ == 0;
+        }
+        constexpr long long* data() {
+            return heap_ ? heap_ : inline_;
+        }
+        constexpr const long long* data() const {
+            return heap_ ? heap_ : inline_;
+        }
+        constexpr long long* begin() {
+            return data();
+        }
+        constexpr const long long* begin() const {
+            return data();
+        }
+        constexpr long long* end() {
+            return data() + size_;
+        }
+        constexpr const long long* end() const {
+            return data() + size_;
+        }
+        constexpr long long& operator[](size_t idx) {
+            return data()[idx];
+        }
+        constexpr const long long& operator[](size_t idx) const {
+            return data()[idx];
+        }
+        constexpr long long& back() {
+            return data()[size_ - 1];
+        }
+        constexpr const long long& back() const {
+            return data()[size_ - 1];
+        }
+
+        // Keeps the first size() limbs.
+        constexpr void reserve(size_t capacity) {
+            if (capacity <= capacity_) {
+                return;
+            }
+            long long* grown =
+                arena_ != nullptr
+                    ? arena_->allocate(arena_->allocator, capacity)
+                    : new long long[capacity];
+            std::copy(begin(), end(), grown);
+            release();
+            heap_ = grown;
+            capacity_ = capacity;
+        }
+
+        // Moves a short enough value back into the object.
+        constexpr void shrink_to_inline() {
+            if (heap_ != nullptr && size_ <= kInlineLimbs_) {
+                std::copy(heap_, heap_ + size_, inline_);
+                release();
+            }
+        }
+
+        constexpr void resize(size_t count, long long value = 0) {
+            if (count > capacity_) {
+                reserve(std::max(count, 2 * capacity_));
+            }
+            if (count > size_) {
+                std::fill(end(), data() + count, value);
+            }
+            size_ = count;
+        }
+
+        constexpr void assign(size_t count, long long value) {
+            size_ = 0;
+            resize(count, value);
+        }
+
+        constexpr void assign(const long long* first, const long long* last) {
+            size_ = 0;
+            reserve(static_cast<size_t>(last - first));
+            size_ = static_cast<size_t>(last - first);
+            std::copy(first, last, data());
+        }
+
+        constexpr void insert(long long* pos, size_t count, long long value) {
+            size_t offset = static_cast<size_t>(pos - data());
+            size_t old_size = size_;
+            resize(size_ + count);
+            std::copy_backward(data() + offset, data() + old_size, end());
+            std::fill(data() + offset, data() + offset + count, value);
+        }
+
+        constexpr void push_back(long long value) {
+            resize(size_ + 1, value);
+        }
+
+        constexpr void pop_back() {
+            --size_;
+        }
+
+        constexpr void swap(Limbs& other) noexcept {
+            Limbs tmp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(tmp);
+        }
+
+        constexpr bool operator==(const Limbs& other) const {
+            return std::equal(begin(), end(), other.begin(), other.end());
+        }
+    };
+
     bool is_negative_ = false;
-    std::vector<long long> digits_;
+    Limbs digits_ = Limbs(1, 0);
+
+    static std::atomic<unsigned> busy_threads_;
+
+    static constexpr long long kBase_ = 1000000000000000000;
+    static constexpr long long kCharsInDigits = 18;
+    static constexpr long long kHalfBase_ = 1000000000;
+
+    static constexpr long long split_wide(unsigned __int128, long long&);
+
+    constexpr void delete_leading_zeroes();
+    // Fast path for values of a single limb: arithmetic in machine words.
+    constexpr bool is_small() const;
+    constexpr long long small_value() const;
+    constexpr void set_small(long long);
+    constexpr void parse(const char*, size_t);
+
+    // Limbs of a _bi literal, parsed during compilation.
+    template <size_t Capacity>
+    struct LiteralValue {
+        bool is_negative = false;
+        size_t size = 1;
+        std::array<long long, Capacity> limbs{};
+    };
+    template <size_t Capacity>
+    static constexpr LiteralValue<Capacity> parse_literal(const char*, size_t);
+    template <size_t Capacity>
+    constexpr explicit BigInteger(const LiteralValue<Capacity>&);
+    constexpr void swap(BigInteger&);
+    constexpr bool is_zero() const;
+
+    static constexpr size_t kNttMaxSize_ = 1 << 22;
+    static constexpr size_t kMinSplitSize_ = 4;
+    static constexpr size_t kNewtonDivisionBorder_ = 1500;
+    static constexpr size_t kReciprocalBorder_ = 64;
+    static constexpr size_t kBarrettBorder_ = 80;
+
+    static BigInteger digits_slice(const BigInteger&, size_t, size_t);
+    void shift_digits(size_t);
+
+    template <bool Subtract>
+    static constexpr long long combine_limbs_scalar(long long*,
+                                                    const long long*,
+                                                    const long long*, size_t,
+                                                    long long);
+#ifdef BIGINTEGER_X86_SIMD
+    template <bool Subtract>
+    static long long combine_limbs_avx2(long long*, const long long*,
+                                        const long long*, size_t);
+    template <bool Subtract>
+    static long long combine_limbs_avx512(long long*, const long long*,
+                                          const long long*, size_t);
+#endif
+    static SimdLevel supported_simd_level();
+    static SimdLevel active_simd_level();
+    // result = lhs +- rhs over n limbs, returns the carry or borrow.
+    template <bool Subtract>
+    static long long combine_limbs(long long*, const long long*,
+                                   const long long*, size_t);
+
+    static long long add_spans(long long*, const long long*, size_t,
+                               const long long*, size_t);
+    static void add_in_place(long long*, size_t, const long long*, size_t);
+    static void sub_in_place(long long*, size_t, const long long*, size_t);
+    static constexpr void schoolbook_kernel(const long long*, size_t,
+                                            const long long*, size_t,
+                                            long long*);
+    static size_t karatsuba_border();
+    static size_t karatsuba_scratch_size(size_t);
+    static void karatsuba_kernel(const long long*, const long long*, size_t,
+                                 long long*, long long*, size_t = 0);
+    template <typename Task>
+    static std::future<void> fork_task(Task&&);
+    static void square_kernel(const long long*, size_t, long long*);
+    static void karatsuba_square_kernel(const long long*, size_t, long long*,
+                                        long long*, size_t = 0);
+    static bool forks_products(size_t);
+    static void pointwise_products(const BigInteger*, const BigInteger*,
+                                   BigInteger*, size_t, bool);
+
+    static BigInteger multiply(const BigInteger&, const BigInteger&);
+    static BigInteger square(const BigInteger&);
+    static BigInteger karatsuba_square(const BigInteger&);
+    static constexpr BigInteger schoolbook_multiplication(const BigInteger&,
+                                                const BigInteger&);
+    static BigInteger unbalanced_multiplication(const BigInteger&,
+                                                const BigInteger&);
+    static BigInteger karatsuba_multiplication(const BigInteger&,
+                                               const BigInteger&);
+    static BigInteger toom3_multiplication(const BigInteger&,
+                                           const BigInteger&);
+    static BigInteger toom4_multiplication(const BigInteger&,
+                                           const BigInteger&);
+
+    static long long pow_mod(long long, long long, long long);
+    static void ntt(std::vector<long long>&, bool, long long, long long);
+    static std::vector<long long> ntt_convolution(const std::vector<long long>&,
+                                                  const std::vector<long long>&,
+                                                  long long, long long);
+    static BigInteger ntt_multiplication(const BigInteger&, const BigInteger&);
 
-    static const long long kBase_ = 1000000000;
-    static const long long kCharsInDigits = 9;
+    static constexpr bool abs_less(const BigInteger&, const BigInteger&);
+    static void knuth_division(const BigInteger&, const BigInteger&,
+                               BigInteger&, BigInteger&);
+    static BigInteger reciprocal(const BigInteger&);
+    static void newton_division(const BigInteger&, const BigInteger&,
+                                BigInteger&, BigInteger&);
 
-    void delete_leading_zeroes();
-    void swap(BigInteger&);
-    bool is_zero() const;
+    static unsigned long long binary_gcd(unsigned long long,
+                                         unsigned long long);
+    static bool lehmer_cofactors(const BigInteger&, const BigInteger&,
+                                 long long (&)[4]);
+    static void linear_combination(const BigInteger&, long long,
+                                   const BigInteger&, long long, BigInteger&);
+    static BigInteger lehmer_gcd(BigInteger, BigInteger, BigInteger*);
 
-    BigInteger karatsuba_multiplication(const BigInteger&, const BigInteger&);
+    static BigInteger product_tree(const std::vector<BigInteger>&,
+                                   const std::vector<size_t>&, size_t, size_t,
+                                   size_t);
+    static std::vector<unsigned long long> primes_up_to(unsigned long long);
+    static BigInteger prime_power_product(
+        const std::vector<unsigned long long>&,
+        const std::vector<unsigned long long>&);
+
+    long long abs_mod_small(long long) const;
+    static long double log_estimate(const BigInteger&);
+    static BigInteger root_estimate(const BigInteger&, unsigned);
+    static BigInteger newton_root(const BigInteger&, unsigned);
+
+    template <typename Multiply>
+    static BigInteger sliding_window_pow(const BigInteger&, const BigInteger&,
+                                         const BigInteger&, Multiply);
+
+    static constexpr unsigned kBinaryIntegerKind_ = 0;
+    static constexpr unsigned kBinaryRationalKind_ = 1;
+    // Stream reads grow a value by at most this many limbs at a time, so a
+    // corrupt count cannot allocate more than the data that actually follows.
+    static constexpr size_t kBinaryChunkLimbs_ = 1 << 16;
+    static void store_word(unsigned long long, char*);
+    static unsigned long long load_word(const char*);
+    void check_binary_value() const;
+    static unsigned long long read_array_header(const char*, unsigned);
+    template <typename Value>
+    static void write_array(std::ostream&, const std::vector<Value>&,
+                            unsigned);
+    template <typename Value>
+    static void read_array(std::istream&, std::vector<Value>&, unsigned);
+    template <typename Value>
+    static const char* read_array(const char*, const char*,
+                                  std::vector<Value>&, unsigned);
 
   public:
-    int sign() {
+    // Minimal operand size (in limbs) at which each multiplication tier
+    // takes over from the previous one.
+    struct MultiplicationThresholds {
+        size_t karatsuba = 20;
+        size_t toom3 = 1500;
+        size_t toom4 = 2500;
+        size_t ntt = 3000;
+    };
+    static MultiplicationThresholds multiplication_thresholds;
+
+    // Opt-in parallel multiplication and squaring: independent sub-products
+    // of at least min_size limbs are forked to other threads. That is the two
+    // outer Karatsuba halves (down to max_depth levels of recursion), the
+    // point products of Toom-3 and Toom-4 and the three prime convolutions
+    // of NTT. threads == 1 keeps everything on the caller.
+    struct ParallelOptions {
+        unsigned threads = 1;
+        size_t min_size = 256;
+        size_t max_depth = 4;
+    };
+    static ParallelOptions parallel_options;
+
+    constexpr int sign() {
         if (is_zero()) {
             return 0;
         }
@@ -29,40 +426,142 @@ class BigInteger {
     }
 
     static BigInteger gcd(const BigInteger&, const BigInteger&);
+    // Returns nonnegative g = gcd(a, b) and stores x, y with a*x + b*y = g.
+    static BigInteger extended_gcd(const BigInteger&, const BigInteger&,
+                                   BigInteger&, BigInteger&);
+    // Truncating division, the remainder takes the sign of the dividend.
+    // Throws std::invalid_argument on a zero divisor.
+    static std::pair<BigInteger, BigInteger> divmod(const BigInteger&,
+                                                    const BigInteger&);
+
+    // In-place scalar arithmetic, one pass over the limbs.
+    constexpr BigInteger& mul_small(long long);
+    constexpr BigInteger& add_small(long long);
+    // Divides in place (truncating) and returns the remainder, which takes
+    // the sign of the dividend. Throws std::invalid_argument on a zero
+    // divisor.
+    long long divmod_small(long long);
+    // this += number * factor.
+    constexpr BigInteger& addmul(const BigInteger&, long long);
+
+    // Product of all values in [first, last) (or in a range) by a balanced
+    // binary tree, parallel per parallel_options.
+    template <typename Iterator>
+    static BigInteger product(Iterator, Iterator);
+    template <typename Range>
+    static BigInteger product(const Range&);
+    static BigInteger factorial(unsigned long long);
+    // Zero for k > n.
+    static BigInteger binomial(unsigned long long, unsigned long long);
+
+    // Floor of the square root of a nonnegative value.
+    static BigInteger isqrt(const BigInteger&);
+    // Floor of the k-th root, truncated toward zero for negative values and
+    // odd k.
+    static BigInteger iroot(const BigInteger&, unsigned);
+    static bool is_perfect_square(const BigInteger&);
+    // True if the value is a^k for some integer a and k >= 2.
+    static bool is_perfect_power(const BigInteger&);
 
-    explicit BigInteger(const std::string&);
+    class Divisor;
+    class MontgomeryContext;
+    class LimbBatch;
+    // base^exponent mod |modulus| in [0, |modulus|) for exponent >= 0.
+    static BigInteger powmod(const BigInteger&, const BigInteger&,
+                             const BigInteger&);
+
+    // Parses an optional '-' and decimal digits at the start of [first, last)
+    // straight into the limbs of the value, reusing its storage, and returns
+    // the end of the number. Throws std::invalid_argument if there are no
+    // digits.
+    static const char* from_chars(const char*, const char*, BigInteger&);
+    // Reads all whitespace-separated numbers of a buffer (such as a mapped
+    // file) or a stream into values. Elements already in values are parsed
+    // over in place, so refilling the same vector allocates only for numbers
+    // that outgrow their predecessors. Returns the count read. Every number
+    // must be followed by whitespace or the end of the input; on a token that
+    // is not a number the buffer overload throws std::invalid_argument and
+    // the stream overload stops with failbit set, keeping the values before.
+    static size_t read_batch(const char*, const char*,
+                             std::vector<BigInteger>&);
+    static size_t read_batch(std::istream&, std::vector<BigInteger>&);
+
+    // Binary format, version kBinaryVersion. A value is a 64-bit header,
+    // limb count << 1 | sign, followed by its base 10^18 limbs, least
+    // significant first, each word little-endian. Every field is 8 bytes, so
+    // values in a mapped file stay aligned, and on a little-endian host
+    // loading a value is a copy of its limbs. Arrays start with an 8-byte
+    // file header (magic, version, element kind) and a 64-bit count.
+    // Malformed or truncated data throws std::invalid_argument and leaves
+    // the target value unchanged.
+    static constexpr unsigned kBinaryVersion = 1;
+    size_t binary_size() const;
+    // Writes binary_size() bytes and returns their end.
+    char* to_binary(char*) const;
+    // Reads one value at the start of [first, last) and returns its end.
+    static const char* from_binary(const char*, const char*, BigInteger&);
+    void write_binary(std::ostream&) const;
+    static void read_binary(std::istream&, BigInteger&);
+    static void write_binary(std::ostream&, const std::vector<BigInteger>&);
+    static void read_binary(std::istream&, std::vector<BigInteger>&);
+    static const char* read_binary(const char*, const char*,
+                                   std::vector<BigInteger>&);
+
+    // Text of a "..."_bi literal as a template argument.
+    template <size_t Size>
+    struct Literal {
+        char chars[Size];
+
+        constexpr Literal(const char (&str)[Size]) {
+            std::copy(str, str + Size, chars);
+        }
+    };
+
+    explicit constexpr BigInteger(const std::string&);
     BigInteger() = default;
-    BigInteger(long long);
+    constexpr BigInteger(long long);
+
+    BigInteger(const BigInteger&) = default;
+    // The source is left equal to zero.
+    constexpr BigInteger(BigInteger&&) noexcept;
+    BigInteger& operator=(const BigInteger&) = default;
+    constexpr BigInteger& operator=(BigInteger&&) noexcept;
 
     ~BigInteger() = default;
 
-    BigInteger operator-() const;
+    constexpr BigInteger operator-() const&;
+    constexpr BigInteger operator-() &&;
 
-    BigInteger operator*(long long) const;
+    constexpr BigInteger operator*(long long) const&;
+    constexpr BigInteger operator*(long long) &&;
 
-    friend std::strong_ordering operator<=>(const BigInteger&,
+    friend constexpr std::strong_ordering operator<=>(const BigInteger&,
                                             const BigInteger&);
 
     friend std::istream& operator>>(std::istream&, BigInteger&);
     friend std::ostream& operator<<(std::ostream&, const BigInteger&);
-    friend BigInteger operator""_bi(const char*, size_t);
+    template <char... Digits>
+    friend constexpr BigInteger operator""_bi();
+    template <Literal Str>
+    friend constexpr BigInteger operator""_bi();
     friend class Rational;
+    friend class BigFloat;
+    template <size_t>
+    friend class FixedBigInt;
 
-    void digitsSubstraction(const std::vector<long long>&,
-                            const std::vector<long long>&);
-    void digitsAddition(const std::vector<long long>&,
-                        const std::vector<long long>&);
+    constexpr void digitsSubstraction(const Limbs&, const Limbs&);
+    constexpr void digitsAddition(const Limbs&, const Limbs&);
 
-    BigInteger& operator+=(const BigInteger&);
-    BigInteger& operator-=(const BigInteger&);
-    BigInteger& operator*=(const BigInteger&);
+    constexpr BigInteger& operator+=(const BigInteger&);
+    constexpr BigInteger& operator-=(const BigInteger&);
+    constexpr BigInteger& operator*=(const BigInteger&);
     BigInteger& operator/=(const BigInteger&);
     BigInteger& operator%=(const BigInteger&);
 
-    BigInteger& operator++();
-    BigInteger& operator--();
-    BigInteger operator++(int) &;
-    BigInteger operator--(int) &;
+    constexpr BigInteger& operator++();
+    constexpr BigInteger& operator--();
+    constexpr BigInteger operator++(int) &;
+    constexpr BigInteger operator--(int) &;
 
     bool operator==(const BigInteger&) const = default;
 
@@ -71,105 +570,336 @@ class BigInteger {
     explicit operator bool();
 };
 
-bool BigInteger::is_zero() const {
+BigInteger::MultiplicationThresholds BigInteger::multiplication_thresholds;
+BigInteger::ParallelOptions BigInteger::parallel_options;
+BigInteger::SimdLevel BigInteger::simd_level = BigInteger::SimdLevel::kAvx512;
+std::atomic<unsigned> BigInteger::busy_threads_{0};
+thread_local BigInteger::LimbArena* BigInteger::limb_arena_ = nullptr;
+
+static_assert(std::is_nothrow_move_constructible_v<BigInteger> &&
+              std::is_nothrow_move_assignable_v<BigInteger>);
+
+template <typename Allocator>
+class BigInteger::ArenaScope {
+    using LimbAllocator = typename std::allocator_traits<
+        Allocator>::template rebind_alloc<long long>;
+
+    LimbAllocator allocator_;
+    LimbArena arena_;
+
+    static long long* allocate(void* allocator, size_t count) {
+        return std::allocator_traits<LimbAllocator>::allocate(
+            *static_cast<LimbAllocator*>(allocator), count);
+    }
+
+    static void deallocate(void* allocator, long long* limbs, size_t count) {
+        std::allocator_traits<LimbAllocator>::deallocate(
+            *static_cast<LimbAllocator*>(allocator), limbs, count);
+    }
+
+  public:
+    explicit ArenaScope(const Allocator& allocator)
+        : allocator_(allocator),
+          arena_{allocate, deallocate, &allocator_, limb_arena_} {
+        limb_arena_ = &arena_;
+    }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    ~ArenaScope() {
+        limb_arena_ = arena_.outer;
+    }
+};
+
+// Returns value / kBase_ and stores value % kBase_ to low, value must be less
+// than kBase_ * 2^64. The quotient comes from a precomputed reciprocal of the
+// normalized base (Moller-Granlund) instead of a 128-bit division call.
+constexpr long long BigInteger::split_wide(unsigned __int128 value,
+                                           long long& low) {
+    const int kShift = 4;
+    const unsigned long long kNormBase = static_cast<unsigned long long>(kBase_)
+                                         << kShift;
+    constexpr unsigned long long kReciprocal =
+        static_cast<unsigned long long>(
+            ((static_cast<unsigned __int128>(~kNormBase) << 64) | ~0ull) /
+            kNormBase);
+
+    unsigned __int128 shifted = value << kShift;
+    unsigned long long high_word = static_cast<unsigned long long>(shifted >> 64);
+    unsigned long long low_word = static_cast<unsigned long long>(shifted);
+
+    unsigned __int128 estimate =
+        static_cast<unsigned __int128>(kReciprocal) * high_word + shifted;
+    unsigned long long quotient =
+        static_cast<unsigned long long>(estimate >> 64) + 1;
+    unsigned long long remainder = low_word - quotient * kNormBase;
+    if (remainder > static_cast<unsigned long long>(estimate)) {
+        --quotient;
+        remainder += kNormBase;
+    }
+    if (remainder >= kNormBase) {
+        ++quotient;
+        remainder -= kNormBase;
+    }
+    low = static_cast<long long>(remainder >> kShift);
+    return static_cast<long long>(quotient);
+}
+
+constexpr bool BigInteger::is_zero() const {
     return digits_.back() == 0;
 }
 
-void BigInteger::delete_leading_zeroes() {
+constexpr void BigInteger::delete_leading_zeroes() {
     while (digits_.size() > 1 && !digits_.back()) {
         digits_.pop_back();
     }
+    if (std::is_constant_evaluated()) {
+        digits_.shrink_to_inline();
+    }
+}
+
+constexpr bool BigInteger::is_small() const {
+    return digits_.size() == 1;
+}
+
+constexpr long long BigInteger::small_value() const {
+    return is_negative_ ? -digits_[0] : digits_[0];
+}
+
+constexpr void BigInteger::set_small(long long value) {
+    is_negative_ = value < 0;
+    unsigned long long magnitude =
+        is_negative_ ? 0ull - static_cast<unsigned long long>(value)
+                     : static_cast<unsigned long long>(value);
+    digits_.resize(1);
+    digits_[0] = static_cast<long long>(magnitude % kBase_);
+    if (magnitude >= static_cast<unsigned long long>(kBase_)) {
+        digits_.push_back(static_cast<long long>(magnitude / kBase_));
+    }
 }
 
-void BigInteger::swap(BigInteger& other) {
+constexpr void BigInteger::swap(BigInteger& other) {
     digits_.swap(other.digits_);
     std::swap(is_negative_, other.is_negative_);
 }
 
-BigInteger::BigInteger(const std::string& inp) {
+constexpr void BigInteger::parse(const char* str, size_t str_size) {
     size_t start = 0;
-    if (inp[0] == '-') {
+    if (str_size && str[0] == '-') {
         is_negative_ = true;
         start = 1;
     } else {
         is_negative_ = false;
     }
-    digits_.clear();
 
-    for (long long i = static_cast<long long>(inp.size()) - 1;
-         i >= static_cast<long long>(start); i -= BigInteger::kCharsInDigits) {
-        digits_.push_back(0);
-        for (size_t j = static_cast<size_t>(
-                 std::max(i - BigInteger::kCharsInDigits + 1,
-                          static_cast<long long>(start)));
-             j <= static_cast<size_t>(i); ++j) {
-            digits_.back() = digits_.back() * 10 +
-                             static_cast<long long>(inp[j]) -
-                             static_cast<long long>('0');
+    size_t digits_count = str_size - start;
+    size_t limbs_count = (digits_count + kCharsInDigits - 1) / kCharsInDigits;
+    digits_.resize(std::max<size_t>(limbs_count, 1));
+    digits_[0] = 0;
+
+    const char* end = str + str_size;
+    for (size_t i = 0; i < limbs_count; ++i) {
+        const char* from = end - std::min<size_t>(
+                                     static_cast<size_t>(kCharsInDigits),
+                                     static_cast<size_t>(end - str) - start);
+        long long limb = 0;
+        for (const char* cur = from; cur != end; ++cur) {
+            limb = limb * 10 + (*cur - '0');
         }
+        digits_[i] = limb;
+        end = from;
     }
 
     delete_leading_zeroes();
-
-    if (digits_.empty()) {
-        digits_.assign(1, 0);
-    }
     if (is_zero()) {
         is_negative_ = false;
     }
 }
 
-BigInteger::BigInteger(long long x) : is_negative_(x < 0) {
-    x = std::abs(x);
-    while (x != 0) {
-        digits_.push_back(x % kBase_);
-        x /= kBase_;
+constexpr BigInteger::BigInteger(const std::string& inp) {
+    parse(inp.data(), inp.size());
+}
+
+constexpr BigInteger::BigInteger(long long x) {
+    set_small(x);
+}
+
+constexpr BigInteger::BigInteger(BigInteger&& other) noexcept
+    : is_negative_(other.is_negative_), digits_(std::move(other.digits_)) {
+    other.is_negative_ = false;
+    other.digits_.assign(1, 0);
+}
+
+constexpr BigInteger& BigInteger::operator=(BigInteger&& other) noexcept {
+    if (this != &other) {
+        is_negative_ = other.is_negative_;
+        digits_ = std::move(other.digits_);
+        other.is_negative_ = false;
+        other.digits_.assign(1, 0);
     }
-    if (digits_.empty()) digits_.push_back(0);
+    return *this;
 }
 
-BigInteger BigInteger::operator-() const {
+constexpr BigInteger BigInteger::operator-() const& {
     BigInteger ans = *this;
-    if (ans.is_zero()) {
-        ans.is_negative_ = false;
-        return ans;
+    return -std::move(ans);
+}
+
+constexpr BigInteger BigInteger::operator-() && {
+    if (!is_zero()) {
+        is_negative_ = !is_negative_;
     }
-    ans.is_negative_ = !is_negative_;
-    return ans;
+    return std::move(*this);
 }
 
-BigInteger operator+(const BigInteger& lhs, const BigInteger& rhs) {
+constexpr BigInteger operator+(const BigInteger& lhs, const BigInteger& rhs) {
     BigInteger ans(lhs);
     ans += rhs;
     return ans;
 }
 
-BigInteger operator-(const BigInteger& lhs, const BigInteger& rhs) {
+// The overloads taking an expiring operand accumulate into its limbs instead
+// of copying the other one.
+constexpr BigInteger operator+(BigInteger&& lhs, const BigInteger& rhs) {
+    lhs += rhs;
+    return std::move(lhs);
+}
+
+constexpr BigInteger operator+(const BigInteger& lhs, BigInteger&& rhs) {
+    rhs += lhs;
+    return std::move(rhs);
+}
+
+constexpr BigInteger operator+(BigInteger&& lhs, BigInteger&& rhs) {
+    lhs += rhs;
+    return std::move(lhs);
+}
+
+constexpr BigInteger operator-(const BigInteger& lhs, const BigInteger& rhs) {
     BigInteger ans(lhs);
     ans -= rhs;
     return ans;
 }
 
-BigInteger operator*(const BigInteger& lhs, const BigInteger& rhs) {
+constexpr BigInteger operator-(BigInteger&& lhs, const BigInteger& rhs) {
+    lhs -= rhs;
+    return std::move(lhs);
+}
+
+constexpr BigInteger operator-(const BigInteger& lhs, BigInteger&& rhs) {
+    rhs -= lhs;
+    return -std::move(rhs);
+}
+
+constexpr BigInteger operator-(BigInteger&& lhs, BigInteger&& rhs) {
+    lhs -= rhs;
+    return std::move(lhs);
+}
+
+constexpr BigInteger operator*(const BigInteger& lhs, const BigInteger& rhs) {
     BigInteger ans(lhs);
     ans *= rhs;
     return ans;
 }
 
+constexpr BigInteger operator*(BigInteger&& lhs, const BigInteger& rhs) {
+    lhs *= rhs;
+    return std::move(lhs);
+}
+
+constexpr BigInteger operator*(const BigInteger& lhs, BigInteger&& rhs) {
+    rhs *= lhs;
+    return std::move(rhs);
+}
+
+constexpr BigInteger operator*(BigInteger&& lhs, BigInteger&& rhs) {
+    lhs *= rhs;
+    return std::move(lhs);
+}
+
 BigInteger operator/(const BigInteger& lhs, const BigInteger& rhs) {
     BigInteger ans(lhs);
     ans /= rhs;
     return ans;
 }
 
+BigInteger operator/(BigInteger&& lhs, const BigInteger& rhs) {
+    lhs /= rhs;
+    return std::move(lhs);
+}
+
 BigInteger operator%(const BigInteger& lhs, const BigInteger& rhs) {
     BigInteger ans(lhs);
     ans %= rhs;
     return ans;
 }
 
-BigInteger BigInteger::karatsuba_multiplication(const BigInteger& lhs,
-                                                const BigInteger& rhs) {
+BigInteger operator%(BigInteger&& lhs, const BigInteger& rhs) {
+    lhs %= rhs;
+    return std::move(lhs);
+}
+
+// Left-to-right binary exponentiation, so every squaring takes the squaring
+// path and only multiplications by base are general ones.
+BigInteger pow(const BigInteger& base, unsigned power) {
+    if (power == 0) {
+        return 1;
+    }
+    BigInteger result(base);
+    for (int bit = std::bit_width(power) - 1; bit-- > 0;) {
+        result *= result;
+        if ((power >> bit) & 1u) {
+            result *= base;
+        }
+    }
+    return result;
+}
+
+BigInteger BigInteger::digits_slice(const BigInteger& number, size_t from,
+                                    size_t to) {
+    BigInteger slice;
+    to = std::min(to, number.digits_.size());
+    if (from >= to) {
+        slice.digits_.assign(1, 0);
+        return slice;
+    }
+    slice.digits_.assign(number.digits_.begin() + static_cast<long>(from),
+                         number.digits_.begin() + static_cast<long>(to));
+    slice.delete_leading_zeroes();
+    return slice;
+}
+
+void BigInteger::shift_digits(size_t shift) {
+    if (is_zero() || shift == 0) {
+        return;
+    }
+    digits_.insert(digits_.begin(), shift, 0);
+}
+
+long long BigInteger::divmod_small(long long x) {
+    if (x == 0) {
+        throw std::invalid_argument("BigInteger: division by zero");
+    }
+    bool divisor_is_neg = x < 0;
+    unsigned long long divisor =
+        divisor_is_neg ? 0ull - static_cast<unsigned long long>(x)
+                       : static_cast<unsigned long long>(x);
+    unsigned long long remainder = 0;
+    for (size_t i = digits_.size(); i-- > 0;) {
+        unsigned __int128 cur =
+            static_cast<unsigned __int128>(remainder) * kBase_ + digits_[i];
+        digits_[i] = static_cast<long long>(cur / divisor);
+        remainder = static_cast<unsigned long long>(cur % divisor);
+    }
+    delete_leading_zeroes();
+    bool was_negative = is_negative_;
+    is_negative_ = !is_zero() && (is_negative_ ^ divisor_is_neg);
+    long long signed_remainder = static_cast<long long>(remainder);
+    return was_negative ? -signed_remainder : signed_remainder;
+}
+
+BigInteger BigInteger::multiply(const BigInteger& lhs, const BigInteger& rhs) {
     if (lhs.is_zero() || rhs.is_zero()) {
         return 0;
     }
@@ -179,560 +909,4214 @@ BigInteger BigInteger::karatsuba_multiplication(const BigInteger& lhs,
     if (lhs == 1 || lhs == -1) {
         return lhs.is_negative_ ? -rhs : rhs;
     }
-
-    const size_t kSquareBorder = 45;
-    if (lhs.digits_.size() <= kSquareBorder) {
-        BigInteger ans(0);
-        for (size_t j = 0; j < rhs.digits_.size(); ++j) {
-            BigInteger cur = lhs * rhs.digits_[j];
-            cur.is_negative_ = false;
-            if (j) {
-                for (size_t i = 0; i < j; ++i)
-                    cur.digits_.push_back(0);
-                rotate(cur.digits_.begin(),
-                       cur.digits_.end() - static_cast<int>(j),
-                       cur.digits_.end());
-            }
-            ans += cur;
-        }
-        if (!ans.is_zero()) {
-            ans.is_negative_ = lhs.is_negative_ ^ rhs.is_negative_;
-        } else {
-            ans.is_negative_ = false;
-        }
+    if (&lhs == &rhs || lhs.digits_ == rhs.digits_) {
+        BigInteger ans = square(lhs);
+        ans.is_negative_ = lhs.is_negative_ ^ rhs.is_negative_;
         return ans;
     }
 
-    BigInteger lhs_left;
-    size_t split_sz = (lhs.digits_.size() + 1) / 2;
-    lhs_left.digits_.assign(lhs.digits_.begin(),
-                            lhs.digits_.begin() + static_cast<int>(split_sz));
-    BigInteger lhs_right;
-    lhs_right.digits_.assign(lhs.digits_.begin() + static_cast<int>(split_sz),
-                             lhs.digits_.end());
-    BigInteger rhs_left;
-    rhs_left.digits_.assign(
-        rhs.digits_.begin(),
-        rhs.digits_.begin() +
-            static_cast<int>(std::min(split_sz, rhs.digits_.size())));
-    BigInteger rhs_right;
-
-    if (split_sz >= rhs.digits_.size()) {
-        rhs_right = 0;
+    const MultiplicationThresholds& borders = multiplication_thresholds;
+    size_t min_sz = std::min(lhs.digits_.size(), rhs.digits_.size());
+    size_t max_sz = std::max(lhs.digits_.size(), rhs.digits_.size());
+    if (min_sz < karatsuba_border()) {
+        return schoolbook_multiplication(lhs, rhs);
+    }
+    if (min_sz >= borders.ntt && min_sz + max_sz <= kNttMaxSize_) {
+        return ntt_multiplication(lhs, rhs);
+    }
+    if (max_sz >= 2 * min_sz) {
+        return unbalanced_multiplication(lhs, rhs);
+    }
+    if (min_sz < borders.toom3) {
+        return karatsuba_multiplication(lhs, rhs);
+    }
+    if (min_sz < borders.toom4) {
+        return toom3_multiplication(lhs, rhs);
+    }
+    return toom4_multiplication(lhs, rhs);
+}
+
+// Same ladder as multiply, but every tier only needs about half of the limb
+// products. The result is nonnegative.
+BigInteger BigInteger::square(const BigInteger& number) {
+    const MultiplicationThresholds& borders = multiplication_thresholds;
+    size_t sz = number.digits_.size();
+    BigInteger ans;
+    if (sz < karatsuba_border()) {
+        ans.digits_.resize(2 * sz);
+        square_kernel(number.digits_.data(), sz, ans.digits_.data());
+        ans.delete_leading_zeroes();
+        return ans;
+    }
+    if (sz >= borders.ntt && 2 * sz <= kNttMaxSize_) {
+        ans = ntt_multiplication(number, number);
+    } else if (sz < borders.toom3) {
+        ans = karatsuba_square(number);
+    } else if (sz < borders.toom4) {
+        ans = toom3_multiplication(number, number);
     } else {
-        rhs_right.digits_.assign(
-            rhs.digits_.begin() + static_cast<int>(split_sz),
-            rhs.digits_.end());
-    }
-
-    BigInteger mul_first = lhs_left * rhs_left;
-    BigInteger mul_second = (lhs_left + lhs_right) * (rhs_left + rhs_right);
-    BigInteger mul_third = lhs_right * rhs_right;
-    mul_second -= mul_first + mul_third;
-    mul_second.digits_.resize(mul_second.digits_.size() + split_sz);
-    rotate(mul_second.digits_.begin(),
-           mul_second.digits_.end() - static_cast<int>(split_sz),
-           mul_second.digits_.end());
-    mul_third.digits_.resize(mul_third.digits_.size() + 2 * split_sz);
-    rotate(mul_third.digits_.begin(),
-           mul_third.digits_.end() - static_cast<int>(2 * split_sz),
-           mul_third.digits_.end());
-    BigInteger res = mul_first + mul_second + mul_third;
-
-    if (!res.is_zero())
-        res.is_negative_ = lhs.is_negative_ ^ rhs.is_negative_;
-    else
-        res.is_negative_ = false;
-    return res;
+        ans = toom4_multiplication(number, number);
+    }
+    ans.is_negative_ = false;
+    return ans;
 }
 
-void BigInteger::digitsSubstraction(const std::vector<long long>& lhs_bits,
-                                    const std::vector<long long>& rhs_bits) {
-    long long remainder = 0;
-    digits_.resize(lhs_bits.size());
+// Cuts the longer operand into pieces as long as the shorter one, so that
+// every partial product is balanced.
+BigInteger BigInteger::unbalanced_multiplication(const BigInteger& lhs,
+                                                 const BigInteger& rhs) {
+    const BigInteger& longer =
+        lhs.digits_.size() >= rhs.digits_.size() ? lhs : rhs;
+    BigInteger shorter = &longer == &lhs ? rhs : lhs;
+    shorter.is_negative_ = false;
+    size_t chunk_sz = shorter.digits_.size();
 
-    for (size_t i = 0; i < lhs_bits.size(); ++i) {
-        long long next_digit =
-            lhs_bits[i] - (i < rhs_bits.size() ? rhs_bits[i] : 0) - remainder;
-        if (next_digit < 0) {
-            next_digit += BigInteger::kBase_;
-            remainder = 1;
-        } else {
-            remainder = 0;
-        }
-        digits_[i] = next_digit;
+    BigInteger ans(0);
+    for (size_t from = 0; from < longer.digits_.size(); from += chunk_sz) {
+        BigInteger part = digits_slice(longer, from, from + chunk_sz);
+        part *= shorter;
+        part.shift_digits(from);
+        ans += part;
     }
+    if (!ans.is_zero()) {
+        ans.is_negative_ = lhs.is_negative_ ^ rhs.is_negative_;
+    }
+    return ans;
+}
 
-    if (remainder) {
-        digits_.back()--;
+constexpr BigInteger BigInteger::schoolbook_multiplication(
+    const BigInteger& lhs, const BigInteger& rhs) {
+    BigInteger ans;
+    ans.digits_.resize(lhs.digits_.size() + rhs.digits_.size());
+    schoolbook_kernel(lhs.digits_.data(), lhs.digits_.size(),
+                      rhs.digits_.data(), rhs.digits_.size(),
+                      ans.digits_.data());
+    ans.delete_leading_zeroes();
+    if (!ans.is_zero()) {
+        ans.is_negative_ = lhs.is_negative_ ^ rhs.is_negative_;
     }
+    return ans;
 }
 
-BigInteger& BigInteger::operator-=(const BigInteger& rhs) {
-    if (is_negative_ == !rhs.is_negative_) {  // redirect to op+() if signs are
-        is_negative_ = !is_negative_;
-        *this += (rhs);
-        delete_leading_zeroes();
-        if (!is_zero()) {
-            is_negative_ = !is_negative_;
+template <bool Subtract>
+constexpr long long BigInteger::combine_limbs_scalar(long long* result,
+                                                     const long long* lhs,
+                                                     const long long* rhs,
+                                                     size_t n,
+                                                     long long remainder) {
+    for (size_t i = 0; i < n; ++i) {
+        if constexpr (Subtract) {
+            long long next_digit = lhs[i] - rhs[i] - remainder;
+            remainder = next_digit < 0;
+            result[i] = remainder ? next_digit + kBase_ : next_digit;
+        } else {
+            long long next_digit = lhs[i] + rhs[i] + remainder;
+            remainder = next_digit >= kBase_;
+            result[i] = remainder ? next_digit - kBase_ : next_digit;
         }
-        return *this;
     }
+    return remainder;
+}
 
-    bool init_is_neg = is_negative_;
-    is_negative_ = rhs.is_negative_;
-    bool is_less_unsigned = (*this < rhs) ^ is_negative_;
-    is_negative_ = is_less_unsigned ? !init_is_neg : init_is_neg;
+#ifdef BIGINTEGER_X86_SIMD
+// Carry-lookahead over the lanes of a vector: lane i generates a carry if
+// lhs[i] +- rhs[i] is out of [0, kBase_) and propagates one if the carry
+// would just reach the boundary. With generate and propagate as bit masks,
+// the integer addition (generate << 1 | carry) + propagate ripples through
+// the propagating lanes, which leaves the lanes receiving a carry in
+// sum ^ propagate and the carry out of the vector in the bit past the last
+// lane.
+template <bool Subtract>
+__attribute__((target("avx2"))) long long BigInteger::combine_limbs_avx2(
+    long long* result, const long long* lhs, const long long* rhs,
+    size_t n) {
+    const __m256i kBaseLanes = _mm256_set1_epi64x(kBase_);
+    const __m256i kEdgeLanes = _mm256_set1_epi64x(Subtract ? 0 : kBase_ - 1);
+    const __m256i kLaneBits = _mm256_setr_epi64x(1, 2, 4, 8);
+    unsigned carry = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i lhs_lanes =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + i));
+        __m256i rhs_lanes =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + i));
+        __m256i lanes = Subtract ? _mm256_sub_epi64(lhs_lanes, rhs_lanes)
+                                 : _mm256_add_epi64(lhs_lanes, rhs_lanes);
+        __m256i out_of_range = Subtract
+                                   ? _mm256_cmpgt_epi64(kEdgeLanes, lanes)
+                                   : _mm256_cmpgt_epi64(lanes, kEdgeLanes);
+        unsigned generate = static_cast<unsigned>(
+            _mm256_movemask_pd(_mm256_castsi256_pd(out_of_range)));
+        unsigned propagate = static_cast<unsigned>(_mm256_movemask_pd(
+            _mm256_castsi256_pd(_mm256_cmpeq_epi64(lanes, kEdgeLanes))));
+        unsigned ripple = ((generate << 1) | carry) + propagate;
+        carry = ripple >> 4;
+        __m256i carried = _mm256_cmpeq_epi64(
+            _mm256_and_si256(
+                _mm256_set1_epi64x(static_cast<long long>(ripple ^ propagate)),
+                kLaneBits),
+            kLaneBits);
+        // carried is -1 in the lanes receiving a carry.
+        lanes = Subtract ? _mm256_add_epi64(lanes, carried)
+                         : _mm256_sub_epi64(lanes, carried);
+        out_of_range = Subtract ? _mm256_cmpgt_epi64(_mm256_setzero_si256(),
+                                                     lanes)
+                                : _mm256_cmpgt_epi64(lanes, _mm256_set1_epi64x(
+                                                                kBase_ - 1));
+        __m256i correction = _mm256_and_si256(out_of_range, kBaseLanes);
+        lanes = Subtract ? _mm256_add_epi64(lanes, correction)
+                         : _mm256_sub_epi64(lanes, correction);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(result + i), lanes);
+    }
+    return combine_limbs_scalar<Subtract>(result + i, lhs + i, rhs + i, n - i,
+                                          carry);
+}
 
-    if (is_less_unsigned) {
-        digitsSubstraction(rhs.digits_, digits_);
-    } else {
-        digitsSubstraction(digits_, rhs.digits_);
+// Same lookahead on eight lanes, with the masks kept in mask registers.
+template <bool Subtract>
+__attribute__((target("avx512f"))) long long
+BigInteger::combine_limbs_avx512(long long* result, const long long* lhs,
+                                 const long long* rhs, size_t n) {
+    const __m512i kBaseLanes = _mm512_set1_epi64(kBase_);
+    const __m512i kEdgeLanes = _mm512_set1_epi64(Subtract ? 0 : kBase_ - 1);
+    const __m512i kOneLanes = _mm512_set1_epi64(1);
+    unsigned carry = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i lhs_lanes = _mm512_loadu_si512(lhs + i);
+        __m512i rhs_lanes = _mm512_loadu_si512(rhs + i);
+        __m512i lanes = Subtract ? _mm512_sub_epi64(lhs_lanes, rhs_lanes)
+                                 : _mm512_add_epi64(lhs_lanes, rhs_lanes);
+        unsigned generate = Subtract ? _mm512_cmplt_epi64_mask(lanes,
+                                                               kEdgeLanes)
+                                     : _mm512_cmpgt_epi64_mask(lanes,
+                                                               kEdgeLanes);
+        unsigned propagate = _mm512_cmpeq_epi64_mask(lanes, kEdgeLanes);
+        unsigned ripple = ((generate << 1) | carry) + propagate;
+        carry = ripple >> 8;
+        __mmask8 carried = static_cast<__mmask8>(ripple ^ propagate);
+        lanes = Subtract ? _mm512_mask_sub_epi64(lanes, carried, lanes,
+                                                 kOneLanes)
+                         : _mm512_mask_add_epi64(lanes, carried, lanes,
+                                                 kOneLanes);
+        __mmask8 out_of_range =
+            Subtract ? _mm512_cmplt_epi64_mask(lanes, _mm512_setzero_si512())
+                     : _mm512_cmpgt_epi64_mask(
+                           lanes, _mm512_set1_epi64(kBase_ - 1));
+        lanes = Subtract ? _mm512_mask_add_epi64(lanes, out_of_range, lanes,
+                                                 kBaseLanes)
+                         : _mm512_mask_sub_epi64(lanes, out_of_range, lanes,
+                                                 kBaseLanes);
+        _mm512_storeu_si512(result + i, lanes);
     }
+    return combine_limbs_scalar<Subtract>(result + i, lhs + i, rhs + i, n - i,
+                                          carry);
+}
+#endif
 
-    delete_leading_zeroes();
-    return *this;
+BigInteger::SimdLevel BigInteger::supported_simd_level() {
+#ifdef BIGINTEGER_X86_SIMD
+    static const SimdLevel kSupported = [] {
+        if (__builtin_cpu_supports("avx512f")) {
+            return SimdLevel::kAvx512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return SimdLevel::kAvx2;
+        }
+        return SimdLevel::kScalar;
+    }();
+    return kSupported;
+#else
+    return SimdLevel::kScalar;
+#endif
 }
 
-void BigInteger::digitsAddition(const std::vector<long long>& lhs_bits,
-                                const std::vector<long long>& rhs_bits) {
-    digits_.resize(lhs_bits.size() + 1);
-    size_t min_sz = rhs_bits.size();
+BigInteger::SimdLevel BigInteger::active_simd_level() {
+    return std::min(simd_level, supported_simd_level());
+}
 
-    long long remainder = 0;
-    size_t i = 0;
-    for (; i < lhs_bits.size(); ++i) {
-        long long next_digit =
-            lhs_bits[i] + (i < min_sz ? rhs_bits[i] : 0) + remainder;
-        if (next_digit >= BigInteger::kBase_) {
-            next_digit -= BigInteger::kBase_;
-            remainder = 1;
-        } else {
-            remainder = 0;
-        }
-        digits_[i] = next_digit;
+template <bool Subtract>
+long long BigInteger::combine_limbs(long long* result, const long long* lhs,
+                                    const long long* rhs, size_t n) {
+#ifdef BIGINTEGER_X86_SIMD
+    switch (active_simd_level()) {
+        case SimdLevel::kAvx512:
+            return combine_limbs_avx512<Subtract>(result, lhs, rhs, n);
+        case SimdLevel::kAvx2:
+            return combine_limbs_avx2<Subtract>(result, lhs, rhs, n);
+        case SimdLevel::kScalar:
+            break;
     }
-    if (remainder) {
-        digits_.back()++;
+#endif
+    return combine_limbs_scalar<Subtract>(result, lhs, rhs, n, 0);
+}
+
+// Stores lhs + rhs (lhs_sz >= rhs_sz) to result and returns the carry.
+long long BigInteger::add_spans(long long* result, const long long* lhs,
+                                size_t lhs_sz, const long long* rhs,
+                                size_t rhs_sz) {
+    long long remainder = combine_limbs<false>(result, lhs, rhs, rhs_sz);
+    for (size_t i = rhs_sz; i < lhs_sz; ++i) {
+        long long next_digit = lhs[i] + remainder;
+        remainder = next_digit >= kBase_;
+        result[i] = remainder ? next_digit - kBase_ : next_digit;
     }
+    return remainder;
 }
 
-BigInteger& BigInteger::operator+=(const BigInteger& rhs) {
-    if (rhs.is_zero()) {
-        return *this;
+// dst += src, the sum must fit into dst_sz >= src_sz limbs.
+void BigInteger::add_in_place(long long* dst, size_t dst_sz,
+                              const long long* src, size_t src_sz) {
+    long long remainder = combine_limbs<false>(dst, dst, src, src_sz);
+    for (size_t i = src_sz; i < dst_sz && remainder; ++i) {
+        long long next_digit = dst[i] + remainder;
+        remainder = next_digit >= kBase_;
+        dst[i] = remainder ? next_digit - kBase_ : next_digit;
     }
-    if (is_negative_ != rhs.is_negative_) {
-        is_negative_ = !is_negative_;
-        *this -= (rhs);
-        delete_leading_zeroes();
-        if (is_zero())
-            is_negative_ = false;
-        else
-            is_negative_ = !is_negative_;
-        return *this;
+}
+
+// dst -= src, dst must not be less than src.
+void BigInteger::sub_in_place(long long* dst, size_t dst_sz,
+                              const long long* src, size_t src_sz) {
+    long long remainder = combine_limbs<true>(dst, dst, src, src_sz);
+    for (size_t i = src_sz; i < dst_sz && remainder; ++i) {
+        long long next_digit = dst[i] - remainder;
+        remainder = next_digit < 0;
+        dst[i] = remainder ? next_digit + kBase_ : next_digit;
     }
+}
 
-    bool is_sz_greater = digits_.size() > rhs.digits_.size();
+// Magnitudes of many values stored limb-major: limb j of value k is at
+// [j * size() + k]. Consecutive values then fill the lanes of a vector
+// register, so elementwise + and - run one independent carry per lane with
+// no lookahead.
+class BigInteger::LimbBatch {
+    size_t size_;
+    size_t limbs_;
+    std::vector<long long> data_;
 
-    if (is_sz_greater) {
-        digitsAddition(digits_, rhs.digits_);
+    template <bool Subtract>
+    static long long combine_lanes_scalar(long long*, const long long*,
+                                          size_t, size_t, size_t);
+#ifdef BIGINTEGER_X86_SIMD
+    template <bool Subtract>
+    static long long combine_lanes_avx2(long long*, const long long*, size_t,
+                                        size_t);
+    template <bool Subtract>
+    static long long combine_lanes_avx512(long long*, const long long*,
+                                          size_t, size_t);
+#endif
+    template <bool Subtract>
+    void combine(const LimbBatch&);
+
+  public:
+    // size zero values of limbs limbs each.
+    LimbBatch(size_t size, size_t limbs)
+        : size_(size), limbs_(limbs), data_(size * limbs, 0) {}
+
+    size_t size() const {
+        return size_;
     }
-    else {
-        digitsAddition(rhs.digits_, digits_);
+    size_t limbs() const {
+        return limbs_;
     }
 
-    delete_leading_zeroes();
-    if (is_zero()) {
-        is_negative_ = false;
+    // Stores |value|, throws std::overflow_error if it needs more than
+    // limbs() limbs.
+    void set(size_t, const BigInteger&);
+    BigInteger get(size_t) const;
+
+    // Elementwise this[k] +- rhs[k] for a batch of the same shape. Throws
+    // std::overflow_error if a sum needs more than limbs() limbs or a
+    // difference is negative; the batch then holds the results modulo
+    // kBase_^limbs().
+    LimbBatch& operator+=(const LimbBatch&);
+    LimbBatch& operator-=(const LimbBatch&);
+};
+
+void BigInteger::LimbBatch::set(size_t index, const BigInteger& value) {
+    if (value.digits_.size() > limbs_) {
+        throw std::overflow_error("LimbBatch: value does not fit");
+    }
+    for (size_t j = 0; j < limbs_; ++j) {
+        data_[j * size_ + index] =
+            j < value.digits_.size() ? value.digits_[j] : 0;
     }
-    return *this;
 }
 
-BigInteger& BigInteger::operator*=(const BigInteger& rhs) {
-    *this = karatsuba_multiplication(*this, rhs);
-    delete_leading_zeroes();
-    return *this;
+BigInteger BigInteger::LimbBatch::get(size_t index) const {
+    BigInteger value;
+    value.digits_.resize(std::max<size_t>(limbs_, 1));
+    for (size_t j = 0; j < limbs_; ++j) {
+        value.digits_[j] = data_[j * size_ + index];
+    }
+    value.delete_leading_zeroes();
+    return value;
 }
 
-BigInteger& BigInteger::operator%=(const BigInteger& rhs) {
-    *this -= (*this / rhs) * rhs;
-    return *this;
+// Lanes [from, size) of the batch, one value after another. Returns nonzero
+// if any of them carries out of the top limb.
+template <bool Subtract>
+long long BigInteger::LimbBatch::combine_lanes_scalar(long long* dst,
+                                                      const long long* src,
+                                                      size_t size,
+                                                      size_t limbs,
+                                                      size_t from) {
+    long long overflow = 0;
+    for (size_t k = from; k < size; ++k) {
+        long long remainder = 0;
+        for (size_t j = 0; j < limbs; ++j) {
+            long long& digit = dst[j * size + k];
+            if constexpr (Subtract) {
+                long long next_digit = digit - src[j * size + k] - remainder;
+                remainder = next_digit < 0;
+                digit = remainder ? next_digit + kBase_ : next_digit;
+            } else {
+                long long next_digit = digit + src[j * size + k] + remainder;
+                remainder = next_digit >= kBase_;
+                digit = remainder ? next_digit - kBase_ : next_digit;
+            }
+        }
+        overflow |= remainder;
+    }
+    return overflow;
 }
 
-BigInteger& BigInteger::operator/=(const BigInteger& rhs_signed) {
-    BigInteger rhs(rhs_signed);
-    size_t div_sz = rhs.digits_.size();
-    delete_leading_zeroes();
-    reverse(digits_.begin(), digits_.end());
-    BigInteger ans(0);
-    ans.is_negative_ = is_negative_ ^ rhs.is_negative_;
-    rhs.is_negative_ = false;
-    is_negative_ = false;
-    BigInteger cur_slice;
-    cur_slice.digits_.assign(digits_.begin(),
-                             digits_.begin() + static_cast<long>(div_sz));
-    reverse(cur_slice.digits_.begin(), cur_slice.digits_.end());
-
-    if (cur_slice < rhs) {
-        if (div_sz == digits_.size()) {
-            if (ans.is_zero()) ans.is_negative_ = false;
-            swap(ans);
-            return *this;
+#ifdef BIGINTEGER_X86_SIMD
+// Four values at a time, the carries stay in a register while the loop walks
+// up their limbs.
+template <bool Subtract>
+__attribute__((target("avx2"))) long long
+BigInteger::LimbBatch::combine_lanes_avx2(long long* dst, const long long* src,
+                                          size_t size, size_t limbs) {
+    const __m256i kBaseLanes = _mm256_set1_epi64x(kBase_);
+    const __m256i kMaxLanes = _mm256_set1_epi64x(kBase_ - 1);
+    __m256i overflow = _mm256_setzero_si256();
+    size_t k = 0;
+    for (; k + 4 <= size; k += 4) {
+        __m256i carried = _mm256_setzero_si256();
+        for (size_t j = 0; j < limbs; ++j) {
+            __m256i* dst_lanes = reinterpret_cast<__m256i*>(dst + j * size + k);
+            __m256i src_lanes = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(src + j * size + k));
+            __m256i lanes = _mm256_loadu_si256(dst_lanes);
+            // carried is -1 in the lanes receiving a carry.
+            if constexpr (Subtract) {
+                lanes = _mm256_add_epi64(_mm256_sub_epi64(lanes, src_lanes),
+                                         carried);
+                carried = _mm256_cmpgt_epi64(_mm256_setzero_si256(), lanes);
+                lanes = _mm256_add_epi64(
+                    lanes, _mm256_and_si256(carried, kBaseLanes));
+            } else {
+                lanes = _mm256_sub_epi64(_mm256_add_epi64(lanes, src_lanes),
+                                         carried);
+                carried = _mm256_cmpgt_epi64(lanes, kMaxLanes);
+                lanes = _mm256_sub_epi64(
+                    lanes, _mm256_and_si256(carried, kBaseLanes));
+            }
+            _mm256_storeu_si256(dst_lanes, lanes);
         }
-        cur_slice.digits_.insert(cur_slice.digits_.begin(), digits_[div_sz]);
+        overflow = _mm256_or_si256(overflow, carried);
     }
+    return (_mm256_testz_si256(overflow, overflow) == 0) |
+           combine_lanes_scalar<Subtract>(dst, src, size, limbs, k);
+}
 
-    for (size_t i = cur_slice.digits_.size(); i <= digits_.size(); ++i) {
-        long long left_border = 0, right_border = kBase_;
-        while (right_border - left_border > 1) {
-            long long middle = (left_border + right_border) / 2;
-            if (rhs * middle <= cur_slice)
-                left_border = middle;
-            else
-                right_border = middle;
-        }
-        ans.digits_.push_back(left_border);
-        cur_slice -= rhs * left_border;
-        if (i != digits_.size()) {
-            cur_slice.digits_.insert(cur_slice.digits_.begin(), digits_[i]);
+template <bool Subtract>
+__attribute__((target("avx512f"))) long long
+BigInteger::LimbBatch::combine_lanes_avx512(long long* dst,
+                                            const long long* src, size_t size,
+                                            size_t limbs) {
+    const __m512i kBaseLanes = _mm512_set1_epi64(kBase_);
+    const __m512i kMaxLanes = _mm512_set1_epi64(kBase_ - 1);
+    const __m512i kOneLanes = _mm512_set1_epi64(1);
+    __mmask8 overflow = 0;
+    size_t k = 0;
+    for (; k + 8 <= size; k += 8) {
+        __mmask8 carried = 0;
+        for (size_t j = 0; j < limbs; ++j) {
+            long long* dst_lanes = dst + j * size + k;
+            __m512i src_lanes = _mm512_loadu_si512(src + j * size + k);
+            __m512i lanes = _mm512_loadu_si512(dst_lanes);
+            if constexpr (Subtract) {
+                lanes = _mm512_sub_epi64(lanes, src_lanes);
+                lanes = _mm512_mask_sub_epi64(lanes, carried, lanes,
+                                              kOneLanes);
+                carried =
+                    _mm512_cmplt_epi64_mask(lanes, _mm512_setzero_si512());
+                lanes = _mm512_mask_add_epi64(lanes, carried, lanes,
+                                              kBaseLanes);
+            } else {
+                lanes = _mm512_add_epi64(lanes, src_lanes);
+                lanes = _mm512_mask_add_epi64(lanes, carried, lanes,
+                                              kOneLanes);
+                carried = _mm512_cmpgt_epi64_mask(lanes, kMaxLanes);
+                lanes = _mm512_mask_sub_epi64(lanes, carried, lanes,
+                                              kBaseLanes);
+            }
+            _mm512_storeu_si512(dst_lanes, lanes);
         }
-        cur_slice.delete_leading_zeroes();
+        overflow |= carried;
     }
-
-    reverse(ans.digits_.begin(), ans.digits_.end());
-    ans.delete_leading_zeroes();
-    if (ans.is_zero()) ans.is_negative_ = false;
-    swap(ans);
-    return *this;
+    return (overflow != 0) |
+           combine_lanes_scalar<Subtract>(dst, src, size, limbs, k);
 }
+#endif
 
-BigInteger BigInteger::operator*(long long x) const {
-    if (is_zero()) return {0};
-    long long remainder = 0;
-    BigInteger ans;
-    bool x_is_neg = (x < 0);
-    x = abs(x);
-
-    for (long long bit : digits_) {
-        long long next_digit = bit * x + remainder;
-        ans.digits_.push_back(next_digit % kBase_);
-        remainder = next_digit / kBase_;
+template <bool Subtract>
+void BigInteger::LimbBatch::combine(const LimbBatch& rhs) {
+    if (size_ != rhs.size_ || limbs_ != rhs.limbs_) {
+        throw std::invalid_argument("LimbBatch: shapes differ");
     }
-
-    while (remainder) {
-        ans.digits_.push_back(remainder % kBase_);
-        remainder /= kBase_;
+    long long overflow = 0;
+    switch (active_simd_level()) {
+#ifdef BIGINTEGER_X86_SIMD
+        case SimdLevel::kAvx512:
+            overflow = combine_lanes_avx512<Subtract>(
+                data_.data(), rhs.data_.data(), size_, limbs_);
+            break;
+        case SimdLevel::kAvx2:
+            overflow = combine_lanes_avx2<Subtract>(
+                data_.data(), rhs.data_.data(), size_, limbs_);
+            break;
+#endif
+        default:
+            overflow = combine_lanes_scalar<Subtract>(
+                data_.data(), rhs.data_.data(), size_, limbs_, 0);
+            break;
     }
-    ans.delete_leading_zeroes();
-    if (ans.is_zero()) {
-        ans.is_negative_ = false;
-    } else {
-        ans.is_negative_ = is_negative_ ^ x_is_neg;
+    if (overflow != 0) {
+        throw std::overflow_error(Subtract ? "LimbBatch: negative difference"
+                                           : "LimbBatch: sum does not fit");
     }
-    return ans;
 }
 
-BigInteger& BigInteger::operator++() {
-    *this += 1;
+BigInteger::LimbBatch& BigInteger::LimbBatch::operator+=(
+    const LimbBatch& rhs) {
+    combine<false>(rhs);
     return *this;
 }
 
-BigInteger& BigInteger::operator--() {
-    *this -= 1;
+BigInteger::LimbBatch& BigInteger::LimbBatch::operator-=(
+    const LimbBatch& rhs) {
+    combine<true>(rhs);
     return *this;
 }
 
-BigInteger BigInteger::operator++(int) & {
-    BigInteger ans(*this);
-    *this += 1;
-    return ans;
+// Writes lhs_sz + rhs_sz limbs of the product to result.
+constexpr void BigInteger::schoolbook_kernel(const long long* lhs,
+                                             size_t lhs_sz,
+                                             const long long* rhs,
+                                             size_t rhs_sz,
+                                             long long* result) {
+    std::fill(result, result + lhs_sz + rhs_sz, 0);
+    for (size_t i = 0; i < lhs_sz; ++i) {
+        long long carry = 0;
+        for (size_t j = 0; j < rhs_sz; ++j) {
+            unsigned __int128 product =
+                static_cast<unsigned __int128>(lhs[i]) * rhs[j] +
+                result[i + j] + carry;
+            carry = split_wide(product, result[i + j]);
+        }
+        result[i + rhs_sz] = carry;
+    }
 }
 
-BigInteger BigInteger::operator--(int) & {
-    BigInteger ans(*this);
-    *this -= 1;
-    return ans;
+size_t BigInteger::karatsuba_border() {
+    return std::max(multiplication_thresholds.karatsuba, kMinSplitSize_);
 }
 
-std::strong_ordering operator<=>(const BigInteger& lhs, const BigInteger& rhs) {
-    if (lhs.is_negative_ != rhs.is_negative_) {
-        return (lhs.is_negative_ > rhs.is_negative_)
-                   ? std::strong_ordering::less
-                   : std::strong_ordering::greater;
-    }
-    bool sign = lhs.is_negative_;
-    if (lhs.digits_.size() != rhs.digits_.size()) {
-        bool unsigned_less = lhs.digits_.size() < rhs.digits_.size();
-        return (unsigned_less ^ sign) ? std::strong_ordering::less
-                                      : std::strong_ordering::greater;
+size_t BigInteger::karatsuba_scratch_size(size_t n) {
+    size_t scratch_sz = 0;
+    size_t border = karatsuba_border();
+    while (n >= border) {
+        size_t low_sz = (n + 1) / 2;
+        scratch_sz += 4 * (low_sz + 1);
+        n = low_sz + 1;
     }
+    return scratch_sz;
+}
 
-    bool equal = true;
-    bool is_less_unsigned;
-    size_t idx = (lhs.digits_.size());
-    while (idx) {
-        idx--;
-        if (lhs.digits_[idx] != rhs.digits_[idx]) {
-            is_less_unsigned = (lhs.digits_[idx] < rhs.digits_[idx]);
-            equal = false;
-            break;
+// Starts the task on a new thread while the parallel_options.threads budget
+// allows it, otherwise defers it to the thread that waits for the result.
+// Inside an ArenaScope the task is always deferred, since the arena belongs
+// to the calling thread.
+template <typename Task>
+std::future<void> BigInteger::fork_task(Task&& task) {
+    // Gives the thread back to the budget even if the task throws.
+    struct BusyThread {
+        ~BusyThread() {
+            --busy_threads_;
+        }
+    };
+    unsigned busy = busy_threads_.load();
+    while (current_arena() == nullptr &&
+           busy + 1 < parallel_options.threads) {
+        if (busy_threads_.compare_exchange_weak(busy, busy + 1)) {
+            try {
+                return std::async(std::launch::async,
+                                  [task = std::forward<Task>(task)]() mutable {
+                                      BusyThread busy_thread;
+                                      task();
+                                  });
+            } catch (...) {
+                --busy_threads_;
+                throw;
+            }
         }
     }
-    if (equal) {
-        return std::strong_ordering::equal;
-    }
-    return is_less_unsigned ^ sign ? std::strong_ordering::less
-                                   : std::strong_ordering::greater;
+    return std::async(std::launch::deferred, std::forward<Task>(task));
 }
 
-std::istream& operator>>(std::istream& input, BigInteger& rhs) {
-    std::string s;
-    input >> s;
-    BigInteger to_swap(s);
-    rhs.swap(to_swap);
-    return input;
+bool BigInteger::forks_products(size_t operand_sz) {
+    return parallel_options.threads > 1 &&
+           operand_sz >= parallel_options.min_size;
 }
 
-std::ostream& operator<<(std::ostream& output, const BigInteger& rhs) {
-    output << rhs.toString();
-    return output;
+// products[i] = lhs[i] * rhs[i] (or lhs[i]^2) for the evaluation points of
+// a Toom split; all but the last are forked when the parts are large enough.
+void BigInteger::pointwise_products(const BigInteger* lhs,
+                                    const BigInteger* rhs,
+                                    BigInteger* products, size_t count,
+                                    bool is_square) {
+    auto product = [=](size_t i) {
+        products[i] = is_square ? square(lhs[i]) : lhs[i] * rhs[i];
+    };
+    if (!forks_products(lhs[0].digits_.size())) {
+        for (size_t i = 0; i < count; ++i) {
+            product(i);
+        }
+        return;
+    }
+    std::vector<std::future<void>> tasks;
+    for (size_t i = 0; i + 1 < count; ++i) {
+        tasks.push_back(fork_task([=] { product(i); }));
+    }
+    product(count - 1);
+    for (std::future<void>& task : tasks) {
+        task.get();
+    }
 }
 
-BigInteger operator""_bi(const char* str, size_t str_size) {
-    BigInteger result;
-    size_t start = 0;
-    if (str[0] == '-') {
-        result.is_negative_ = true;
-        start = 1;
-    } else {
-        result.is_negative_ = false;
+// Multiplies two n-limb magnitudes into 2n limbs of result. The sums of the
+// halves and their product live in scratch, deeper levels reuse the rest of
+// it, so the whole recursion works in karatsuba_scratch_size(n) limbs.
+// Forked sub-products get scratch buffers of their own.
+void BigInteger::karatsuba_kernel(const long long* lhs, const long long* rhs,
+                                  size_t n, long long* result,
+                                  long long* scratch, size_t depth) {
+    if (n < karatsuba_border()) {
+        schoolbook_kernel(lhs, n, rhs, n, result);
+        return;
     }
-    for (long long i = static_cast<long long>(str_size) - 1;
-         i >= static_cast<long long>(start); i -= BigInteger::kCharsInDigits) {
-        result.digits_.push_back(0);
-        for (size_t j = static_cast<size_t>(
-                 std::max(i - BigInteger::kCharsInDigits + 1,
-                          static_cast<long long>(start)));
-             j <= static_cast<size_t>(i); ++j) {
-            result.digits_.back() = result.digits_.back() * 10 +
-                                    static_cast<long long>(str[j]) -
-                                    static_cast<long long>('0');
-        }
+    size_t low_sz = (n + 1) / 2;
+    size_t high_sz = n - low_sz;
+    long long* lhs_sum = scratch;
+    long long* rhs_sum = lhs_sum + low_sz + 1;
+    long long* middle = rhs_sum + low_sz + 1;
+    long long* rest = middle + 2 * (low_sz + 1);
+
+    if (depth < parallel_options.max_depth && forks_products(high_sz)) {
+        std::vector<long long> low_scratch(karatsuba_scratch_size(low_sz));
+        std::vector<long long> high_scratch(karatsuba_scratch_size(high_sz));
+        std::future<void> low_task = fork_task([&] {
+            karatsuba_kernel(lhs, rhs, low_sz, result, low_scratch.data(),
+                             depth + 1);
+        });
+        std::future<void> high_task = fork_task([&] {
+            karatsuba_kernel(lhs + low_sz, rhs + low_sz, high_sz,
+                             result + 2 * low_sz, high_scratch.data(),
+                             depth + 1);
+        });
+        lhs_sum[low_sz] =
+            add_spans(lhs_sum, lhs, low_sz, lhs + low_sz, high_sz);
+        rhs_sum[low_sz] =
+            add_spans(rhs_sum, rhs, low_sz, rhs + low_sz, high_sz);
+        karatsuba_kernel(lhs_sum, rhs_sum, low_sz + 1, middle, rest,
+                         depth + 1);
+        low_task.get();
+        high_task.get();
+    } else {
+        karatsuba_kernel(lhs, rhs, low_sz, result, rest, depth + 1);
+        karatsuba_kernel(lhs + low_sz, rhs + low_sz, high_sz,
+                         result + 2 * low_sz, rest, depth + 1);
+        lhs_sum[low_sz] =
+            add_spans(lhs_sum, lhs, low_sz, lhs + low_sz, high_sz);
+        rhs_sum[low_sz] =
+            add_spans(rhs_sum, rhs, low_sz, rhs + low_sz, high_sz);
+        karatsuba_kernel(lhs_sum, rhs_sum, low_sz + 1, middle, rest,
+                         depth + 1);
     }
 
-    result.delete_leading_zeroes();
+    size_t middle_sz = 2 * (low_sz + 1);
+    sub_in_place(middle, middle_sz, result, 2 * low_sz);
+    sub_in_place(middle, middle_sz, result + 2 * low_sz, 2 * high_sz);
+    add_in_place(result + low_sz, 2 * n - low_sz, middle,
+                 std::min(middle_sz, 2 * n - low_sz));
+}
 
-    if (result.digits_.empty()) {
-        result.digits_.assign(1, 0);
+// Writes 2n limbs of the square: every cross product is computed once and
+// doubled, then the diagonal squares are added.
+void BigInteger::square_kernel(const long long* number, size_t n,
+                               long long* result) {
+    std::fill(result, result + 2 * n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        long long carry = 0;
+        for (size_t j = i + 1; j < n; ++j) {
+            unsigned __int128 product =
+                static_cast<unsigned __int128>(number[i]) * number[j] +
+                result[i + j] + carry;
+            carry = split_wide(product, result[i + j]);
+        }
+        result[i + n] = carry;
     }
-    if (result.is_zero()) {
-        result.is_negative_ = false;
+
+    long long remainder = 0;
+    for (size_t i = 0; i < 2 * n; ++i) {
+        long long next_digit = 2 * result[i] + remainder;
+        remainder = next_digit >= kBase_;
+        result[i] = remainder ? next_digit - kBase_ : next_digit;
     }
-    return result;
-}
 
-BigInteger operator""_bi(unsigned long long c) {
-    if (c > LLONG_MAX) {
-        long long remainder = static_cast<long long>(c % 10ull);
-        c /= 10ull;
-        BigInteger ans(static_cast<long long>(c));
-        ans *= 10;
-        ans += remainder;
-        return ans;
+    long long carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        unsigned __int128 product =
+            static_cast<unsigned __int128>(number[i]) * number[i] +
+            result[2 * i] + carry;
+        carry = split_wide(product, result[2 * i]);
+        long long next_digit = result[2 * i + 1] + carry;
+        carry = next_digit >= kBase_;
+        result[2 * i + 1] = carry ? next_digit - kBase_ : next_digit;
     }
-    return static_cast<long long>(c);
 }
 
-std::string BigInteger::toString() const {
-    std::string ans;
-    for (long long x : digits_) {
-        std::string cur_ans;
-        for (long long j = 0; j < BigInteger::kCharsInDigits; ++j) {
-            cur_ans += static_cast<char>(x % 10 + '0');
-            x /= 10;
-        }
-        ans += cur_ans;
-    }
-    while (ans.size() > 1 && ans.back() == '0') {
-        ans.pop_back();
+void BigInteger::karatsuba_square_kernel(const long long* number, size_t n,
+                                         long long* result,
+                                         long long* scratch, size_t depth) {
+    if (n < karatsuba_border()) {
+        square_kernel(number, n, result);
+        return;
     }
-    if (is_zero()) {
-        ans = "0";
-    } else if (is_negative_) {
-        ans.push_back('-');
+    size_t low_sz = (n + 1) / 2;
+    size_t high_sz = n - low_sz;
+    long long* sum = scratch;
+    long long* middle = sum + low_sz + 1;
+    long long* rest = middle + 2 * (low_sz + 1);
+
+    sum[low_sz] = add_spans(sum, number, low_sz, number + low_sz, high_sz);
+    if (depth < parallel_options.max_depth && forks_products(high_sz)) {
+        std::vector<long long> low_scratch(karatsuba_scratch_size(low_sz));
+        std::vector<long long> high_scratch(karatsuba_scratch_size(high_sz));
+        std::future<void> low_task = fork_task([&] {
+            karatsuba_square_kernel(number, low_sz, result,
+                                    low_scratch.data(), depth + 1);
+        });
+        std::future<void> high_task = fork_task([&] {
+            karatsuba_square_kernel(number + low_sz, high_sz,
+                                    result + 2 * low_sz, high_scratch.data(),
+                                    depth + 1);
+        });
+        karatsuba_square_kernel(sum, low_sz + 1, middle, rest, depth + 1);
+        low_task.get();
+        high_task.get();
+    } else {
+        karatsuba_square_kernel(number, low_sz, result, rest, depth + 1);
+        karatsuba_square_kernel(number + low_sz, high_sz,
+                                result + 2 * low_sz, rest, depth + 1);
+        karatsuba_square_kernel(sum, low_sz + 1, middle, rest, depth + 1);
     }
-    reverse(ans.begin(), ans.end());
-    return ans;
+    size_t middle_sz = 2 * (low_sz + 1);
+    sub_in_place(middle, middle_sz, result, 2 * low_sz);
+    sub_in_place(middle, middle_sz, result + 2 * low_sz, 2 * high_sz);
+    add_in_place(result + low_sz, 2 * n - low_sz, middle,
+                 std::min(middle_sz, 2 * n - low_sz));
 }
 
-BigInteger::operator bool() {
-    return !is_zero();
+BigInteger BigInteger::karatsuba_square(const BigInteger& number) {
+    size_t n = number.digits_.size();
+    std::vector<long long> scratch(karatsuba_scratch_size(n));
+    BigInteger res;
+    res.digits_.resize(2 * n);
+    karatsuba_square_kernel(number.digits_.data(), n, res.digits_.data(),
+                            scratch.data());
+    res.delete_leading_zeroes();
+    return res;
 }
 
-BigInteger BigInteger::gcd(const BigInteger& a, const BigInteger& b) {
-    if (b.is_zero()) {
-        return a;
+BigInteger BigInteger::karatsuba_multiplication(const BigInteger& lhs,
+                                                const BigInteger& rhs) {
+    size_t n = std::max(lhs.digits_.size(), rhs.digits_.size());
+    std::vector<long long> scratch(n + karatsuba_scratch_size(n), 0);
+
+    const long long* lhs_bits = lhs.digits_.data();
+    const long long* rhs_bits = rhs.digits_.data();
+    if (lhs.digits_.size() < n) {
+        std::copy(lhs.digits_.begin(), lhs.digits_.end(), scratch.begin());
+        lhs_bits = scratch.data();
+    } else if (rhs.digits_.size() < n) {
+        std::copy(rhs.digits_.begin(), rhs.digits_.end(), scratch.begin());
+        rhs_bits = scratch.data();
     }
-    return gcd(b, a % b);
-};
 
-class Rational {
-    BigInteger numerator_;
-    BigInteger denominator_;
+    BigInteger res;
+    res.digits_.resize(2 * n);
+    karatsuba_kernel(lhs_bits, rhs_bits, n, res.digits_.data(),
+                     scratch.data() + n);
+    res.delete_leading_zeroes();
+    if (!res.is_zero()) {
+        res.is_negative_ = lhs.is_negative_ ^ rhs.is_negative_;
+    }
+    return res;
+}
 
-    void to_prime_form() {
-        bool is_neg = (numerator_.sign() * denominator_.sign() == -1);
+// Toom-3 with evaluation points 0, 1, -1, -2 and infinity and Bodrato's
+// interpolation sequence.
+BigInteger BigInteger::toom3_multiplication(const BigInteger& lhs,
+                                            const BigInteger& rhs) {
+    size_t part_sz =
+        (std::max(lhs.digits_.size(), rhs.digits_.size()) + 2) / 3;
 
-        if (numerator_.sign() == -1) {
-            numerator_ *= -1;
-        }
+    BigInteger lhs_parts[3];
+    BigInteger rhs_parts[3];
+    for (size_t i = 0; i < 3; ++i) {
+        lhs_parts[i] = digits_slice(lhs, i * part_sz, (i + 1) * part_sz);
+        rhs_parts[i] = digits_slice(rhs, i * part_sz, (i + 1) * part_sz);
+    }
 
-        if (denominator_.sign() == -1) {
-            denominator_ *= -1;
-        }
+    auto evaluate = [](const BigInteger* parts, BigInteger* values) {
+        BigInteger middle = parts[0] + parts[2];
+        values[0] = parts[0];
+        values[1] = middle + parts[1];
+        values[2] = middle - parts[1];
+        values[3] = (values[2] + parts[2]) * 2 - parts[0];
+        values[4] = parts[2];
+    };
+    BigInteger lhs_values[5];
+    BigInteger rhs_values[5];
+    evaluate(lhs_parts, lhs_values);
+    bool is_square = &lhs == &rhs;
+    if (!is_square) {
+        evaluate(rhs_parts, rhs_values);
+    }
 
-        BigInteger gcd_ = BigInteger::gcd(numerator_, denominator_);
-        numerator_ /= gcd_;
-        denominator_ /= gcd_;
-        if (is_neg) numerator_ *= -1;
+    BigInteger products[5];
+    pointwise_products(lhs_values, rhs_values, products, 5, is_square);
+    const BigInteger& r0 = products[0];
+    const BigInteger& r_inf = products[4];
+
+    BigInteger r3 = products[3] - products[1];
+    r3.divmod_small(3);
+    BigInteger r1 = products[1] - products[2];
+    r1.divmod_small(2);
+    BigInteger r2 = products[2] - r0;
+    r3 = r2 - r3;
+    r3.divmod_small(2);
+    r3 += r_inf * 2;
+    r2 += r1;
+    r2 -= r_inf;
+    r1 -= r3;
+
+    BigInteger coefficients[5] = {r0, r1, r2, r3, r_inf};
+    BigInteger res(0);
+    for (size_t i = 0; i < 5; ++i) {
+        coefficients[i].shift_digits(i * part_sz);
+        res += coefficients[i];
     }
+    if (!res.is_zero()) {
+        res.is_negative_ = lhs.is_negative_ ^ rhs.is_negative_;
+    }
+    return res;
+}
 
-  public:
-    Rational() = default;
+// Toom-4 with evaluation points 0, 1, -1, 2, -2, 1/2 and infinity.
+BigInteger BigInteger::toom4_multiplication(const BigInteger& lhs,
+                                            const BigInteger& rhs) {
+    size_t part_sz =
+        (std::max(lhs.digits_.size(), rhs.digits_.size()) + 3) / 4;
 
-    Rational(const BigInteger& numerator, const BigInteger& denominator)
-        : numerator_(numerator), denominator_(denominator) {
-        to_prime_form();
+    BigInteger lhs_parts[4];
+    BigInteger rhs_parts[4];
+    for (size_t i = 0; i < 4; ++i) {
+        lhs_parts[i] = digits_slice(lhs, i * part_sz, (i + 1) * part_sz);
+        rhs_parts[i] = digits_slice(rhs, i * part_sz, (i + 1) * part_sz);
     }
 
-    Rational(const BigInteger& x) : numerator_(x), denominator_(1) {
-        to_prime_form();
+    auto evaluate = [](const BigInteger* parts, BigInteger* values) {
+        BigInteger even = parts[0] + parts[2];
+        BigInteger odd = parts[1] + parts[3];
+        values[0] = parts[0];
+        values[1] = even + odd;
+        values[2] = even - odd;
+        even = parts[0] + parts[2] * 4;
+        odd = parts[1] * 2 + parts[3] * 8;
+        values[3] = even + odd;
+        values[4] = even - odd;
+        values[5] = parts[0] * 8 + parts[1] * 4 + parts[2] * 2 + parts[3];
+        values[6] = parts[3];
+    };
+    BigInteger lhs_values[7];
+    BigInteger rhs_values[7];
+    evaluate(lhs_parts, lhs_values);
+    bool is_square = &lhs == &rhs;
+    if (!is_square) {
+        evaluate(rhs_parts, rhs_values);
     }
 
-    Rational(long long x) : numerator_(x), denominator_(1) {}
+    BigInteger products[7];
+    pointwise_products(lhs_values, rhs_values, products, 7, is_square);
+    const BigInteger& c0 = products[0];
+    const BigInteger& c6 = products[6];
 
-    Rational& operator+=(const Rational&);
-    Rational& operator-=(const Rational&);
-    Rational& operator*=(const Rational&);
-    Rational& operator/=(const Rational&);
-    Rational operator-() const;
-    friend std::strong_ordering operator<=>(const Rational&, const Rational&);
-    friend std::istream& operator>>(std::istream&, Rational&);
-    bool operator==(const Rational&) const = default;
-    std::string toString() const;
-    std::string asDecimal(size_t);
-    explicit operator double();
-};
+    BigInteger odd_one = products[1] - products[2];
+    odd_one.divmod_small(2);
+    BigInteger even_two = products[3] + products[4];
+    even_two.divmod_small(2);
+    BigInteger odd_two = products[3] - products[4];
+    odd_two.divmod_small(4);
 
-std::istream& operator>>(std::istream& input, Rational& number) {
-    input >> number.numerator_;
-    return input;
-}
+    BigInteger c2_c4 = products[1] + products[2];
+    c2_c4.divmod_small(2);
+    c2_c4 -= c0 + c6;
+    BigInteger c4 = even_two - c0 - c6 * 64;
+    c4.divmod_small(4);
+    c4 -= c2_c4;
+    c4.divmod_small(3);
+    BigInteger c2 = c2_c4 - c4;
 
-Rational operator+(const Rational& lhs, const Rational& rhs) {
-    Rational ans(lhs);
-    ans += rhs;
-    return ans;
-}
+    BigInteger half = products[5] - c0 * 64 - c2 * 16 - c4 * 4 - c6;
+    half.divmod_small(2);
+    BigInteger c3_c5 = odd_two - odd_one;
+    c3_c5.divmod_small(3);
+    BigInteger c3 = odd_one * 16 - half;
+    c3.divmod_small(3);
+    c3 -= c3_c5;
+    c3.divmod_small(3);
+    BigInteger c5 = c3_c5 - c3;
+    c5.divmod_small(5);
+    BigInteger c1 = odd_one - c3 - c5;
 
-Rational operator-(const Rational& lhs, const Rational& rhs) {
-    Rational ans(lhs);
-    ans -= rhs;
-    return ans;
+    BigInteger coefficients[7] = {c0, c1, c2, c3, c4, c5, c6};
+    BigInteger res(0);
+    for (size_t i = 0; i < 7; ++i) {
+        coefficients[i].shift_digits(i * part_sz);
+        res += coefficients[i];
+    }
+    if (!res.is_zero()) {
+        res.is_negative_ = lhs.is_negative_ ^ rhs.is_negative_;
+    }
+    return res;
 }
 
-Rational operator*(const Rational& lhs, const Rational& rhs) {
-    Rational ans(lhs);
-    ans *= rhs;
-    return ans;
+long long BigInteger::pow_mod(long long base, long long power, long long mod) {
+    long long result = 1;
+    base %= mod;
+    while (power) {
+        if (power & 1) {
+            result = result * base % mod;
+        }
+        base = base * base % mod;
+        power >>= 1;
+    }
+    return result;
 }
 
-Rational operator/(const Rational& lhs, const Rational& rhs) {
-    Rational ans(lhs);
-    ans /= rhs;
-    return ans;
-}
+void BigInteger::ntt(std::vector<long long>& values, bool invert,
+                     long long mod, long long root) {
+    size_t n = values.size();
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(values[i], values[j]);
+        }
+    }
 
-Rational& Rational::operator+=(const Rational& rhs) {
-    numerator_ *= rhs.denominator_;
-    numerator_ += rhs.numerator_ * denominator_;
-    denominator_ *= rhs.denominator_;
-    to_prime_form();
-    return *this;
-}
+    std::vector<long long> roots(n / 2 + 1);
+    for (size_t len = 2; len <= n; len <<= 1) {
+        long long step = pow_mod(root, (mod - 1) / static_cast<long long>(len),
+                                 mod);
+        if (invert) {
+            step = pow_mod(step, mod - 2, mod);
+        }
+        size_t half = len / 2;
+        roots[0] = 1;
+        for (size_t k = 1; k < half; ++k) {
+            roots[k] = roots[k - 1] * step % mod;
+        }
+        for (size_t i = 0; i < n; i += len) {
+            for (size_t k = 0; k < half; ++k) {
+                long long u = values[i + k];
+                long long v = values[i + k + half] * roots[k] % mod;
+                values[i + k] = u + v < mod ? u + v : u + v - mod;
+                values[i + k + half] = u - v >= 0 ? u - v : u - v + mod;
+            }
+        }
+    }
 
-Rational& Rational::operator-=(const Rational& rhs) {
-    numerator_ *= rhs.denominator_;
-    numerator_ -= rhs.numerator_ * denominator_;
-    denominator_ *= rhs.denominator_;
-    to_prime_form();
-    return *this;
+    if (invert) {
+        long long n_inv = pow_mod(static_cast<long long>(n), mod - 2, mod);
+        for (long long& x : values) {
+            x = x * n_inv % mod;
+        }
+    }
 }
 
-Rational& Rational::operator*=(const Rational& rhs) {
-    numerator_ *= rhs.numerator_;
-    denominator_ *= rhs.denominator_;
-    to_prime_form();
-    return *this;
+std::vector<long long> BigInteger::ntt_convolution(
+    const std::vector<long long>& lhs_bits,
+    const std::vector<long long>& rhs_bits, long long mod, long long root) {
+    size_t n = 1;
+    while (n < lhs_bits.size() + rhs_bits.size()) {
+        n <<= 1;
+    }
+    std::vector<long long> lhs_values(n, 0);
+    for (size_t i = 0; i < lhs_bits.size(); ++i) {
+        lhs_values[i] = lhs_bits[i] % mod;
+    }
+    ntt(lhs_values, false, mod, root);
+    if (&lhs_bits == &rhs_bits) {
+        for (size_t i = 0; i < n; ++i) {
+            lhs_values[i] = lhs_values[i] * lhs_values[i] % mod;
+        }
+    } else {
+        std::vector<long long> rhs_values(n, 0);
+        for (size_t i = 0; i < rhs_bits.size(); ++i) {
+            rhs_values[i] = rhs_bits[i] % mod;
+        }
+        ntt(rhs_values, false, mod, root);
+        for (size_t i = 0; i < n; ++i) {
+            lhs_values[i] = lhs_values[i] * rhs_values[i] % mod;
+        }
+    }
+    ntt(lhs_values, true, mod, root);
+    return lhs_values;
 }
 
-Rational& Rational::operator/=(const Rational& rhs) {
-    numerator_ *= rhs.denominator_;
-    denominator_ *= rhs.numerator_;
-    to_prime_form();
-    return *this;
-}
+// Limbs are split into kHalfBase_ halves, convolved modulo three NTT-friendly
+// primes and restored with CRT: every coefficient of the half-limb product is
+// below kNttMaxSize_ * kHalfBase_^2 < p1 * p2 * p3.
+BigInteger BigInteger::ntt_multiplication(const BigInteger& lhs,
+                                          const BigInteger& rhs) {
+    const long long kMods[3] = {998244353, 167772161, 469762049};
+    const long long kRoot = 3;
 
-Rational Rational::operator-() const {
-    Rational result(*this);
-    result.numerator_.is_negative_ ^= 1;
-    return result;
-}
+    auto split_halves = [](const Limbs& bits) {
+        std::vector<long long> halves(2 * bits.size());
+        for (size_t i = 0; i < bits.size(); ++i) {
+            halves[2 * i] = bits[i] % kHalfBase_;
+            halves[2 * i + 1] = bits[i] / kHalfBase_;
+        }
+        return halves;
+    };
+    std::vector<long long> lhs_halves = split_halves(lhs.digits_);
+    std::vector<long long> rhs_halves;
+    if (&lhs != &rhs) {
+        rhs_halves = split_halves(rhs.digits_);
+    }
+    const std::vector<long long>& rhs_source =
+        &lhs == &rhs ? lhs_halves : rhs_halves;
 
-std::strong_ordering operator<=>(const Rational& lhs, const Rational& rhs) {
-    BigInteger left(lhs.numerator_ * rhs.denominator_);
-    BigInteger right(lhs.denominator_ * rhs.numerator_);
-    return left <=> right;
-}
+    std::vector<long long> residues[3];
+    auto convolve = [&](size_t i) {
+        residues[i] = ntt_convolution(lhs_halves, rhs_source, kMods[i], kRoot);
+    };
+    if (forks_products(lhs.digits_.size())) {
+        std::future<void> first_task = fork_task([&] { convolve(0); });
+        std::future<void> second_task = fork_task([&] { convolve(1); });
+        convolve(2);
+        first_task.get();
+        second_task.get();
+    } else {
+        for (size_t i = 0; i < 3; ++i) {
+            convolve(i);
+        }
+    }
 
-std::string Rational::toString() const {
-    Rational ans_rational = *this;
-    ans_rational.to_prime_form();
-    std::string ans = ans_rational.numerator_.toString();
-    if (ans_rational.denominator_ == BigInteger(1)) return ans;
-    ans += "/" + ans_rational.denominator_.toString();
-    return ans;
-}
+    const long long kInv01 = pow_mod(kMods[0], kMods[1] - 2, kMods[1]);
+    const long long kInv012 =
+        pow_mod(kMods[0] * kMods[1] % kMods[2], kMods[2] - 2, kMods[2]);
+    const long long kMod01 = kMods[0] * kMods[1];
 
-std::string Rational::asDecimal(size_t precision = 0) {
-    if (precision == 0) {
-        return (numerator_ / denominator_).toString();
+    size_t result_sz = lhs.digits_.size() + rhs.digits_.size();
+    BigInteger ans;
+    ans.digits_.assign(result_sz, 0);
+    unsigned __int128 remainder = 0;
+    for (size_t i = 0; i < 2 * result_sz; ++i) {
+        long long x0 = residues[0][i];
+        long long x1 = (residues[1][i] - x0 % kMods[1] + kMods[1]) % kMods[1] *
+                       kInv01 % kMods[1];
+        long long low = x0 + x1 * kMods[0];
+        long long x2 = (residues[2][i] - low % kMods[2] + kMods[2]) % kMods[2] *
+                       kInv012 % kMods[2];
+        unsigned __int128 coefficient =
+            static_cast<unsigned __int128>(x2) * kMod01 + low + remainder;
+        long long half = static_cast<long long>(coefficient % kHalfBase_);
+        ans.digits_[i / 2] += i % 2 ? half * kHalfBase_ : half;
+        remainder = coefficient / kHalfBase_;
     }
-    bool is_neg = numerator_.sign() * denominator_.sign() == -1;
-    if (numerator_.sign() == -1) numerator_ *= -1;
-    BigInteger precise_number(numerator_);
-    for (size_t i = 0; i < precision; ++i) {
-        precise_number *= 10;
+
+    ans.delete_leading_zeroes();
+    if (!ans.is_zero()) {
+        ans.is_negative_ = lhs.is_negative_ ^ rhs.is_negative_;
     }
-    std::string int_part;
+    return ans;
+}
 
-    if (is_neg && numerator_ != 0_bi) int_part.push_back('-');
+constexpr void BigInteger::digitsSubstraction(const Limbs& lhs_bits,
+                                               const Limbs& rhs_bits) {
+    size_t lhs_sz = lhs_bits.size();
+    size_t rhs_sz = std::min(rhs_bits.size(), lhs_sz);
+    digits_.resize(lhs_sz);
 
-    int_part += (numerator_ / denominator_).toString();
-    std::string fractional_part = (precise_number / denominator_).toString();
-    while (fractional_part.size() < precision) {
-        fractional_part.insert(fractional_part.begin(), '0');
+    long long remainder =
+        std::is_constant_evaluated()
+            ? combine_limbs_scalar<true>(digits_.data(), lhs_bits.data(),
+                                         rhs_bits.data(), rhs_sz, 0)
+            : combine_limbs<true>(digits_.data(), lhs_bits.data(),
+                                  rhs_bits.data(), rhs_sz);
+    size_t i = rhs_sz;
+    for (; i < lhs_sz && remainder; ++i) {
+        long long next_digit = lhs_bits[i] - remainder;
+        remainder = next_digit < 0;
+        digits_[i] = remainder ? next_digit + kBase_ : next_digit;
+    }
+    if (&lhs_bits != &digits_) {
+        std::copy(lhs_bits.begin() + static_cast<long>(i), lhs_bits.end(),
+                  digits_.begin() + static_cast<long>(i));
     }
-    int_part.push_back('.');
-    int_part +=
-        fractional_part.substr(static_cast<size_t>(std::max(
-                                   0, static_cast<int>(fractional_part.size()) -
-                                          static_cast<int>(precision))),
-                               precision);
-    return int_part;
 }
 
-Rational::operator double() {
-    const int kPrecision = 15;
-    return std::stod(asDecimal(kPrecision));
-}
\ No newline at end of file
+constexpr BigInteger& BigInteger::operator-=(const BigInteger& rhs) {
+    if (is_small() && rhs.is_small()) {
+        set_small(small_value() - rhs.small_value());
+        return *this;
+    }
+    if (is_negative_ == !rhs.is_negative_) {  // redirect to op+() if signs are
+        is_negative_ = !is_negative_;
+        *this += (rhs);
+        delete_leading_zeroes();
+        if (!is_zero()) {
+            is_negative_ = !is_negative_;
+        }
+        return *this;
+    }
+
+    bool init_is_neg = is_negative_;
+    is_negative_ = rhs.is_negative_;
+    bool is_less_unsigned = (*this < rhs) ^ is_negative_;
+    is_negative_ = is_less_unsigned ? !init_is_neg : init_is_neg;
+
+    if (is_less_unsigned) {
+        digitsSubstraction(rhs.digits_, digits_);
+    } else {
+        digitsSubstraction(digits_, rhs.digits_);
+    }
+
+    delete_leading_zeroes();
+    return *this;
+}
+
+constexpr void BigInteger::digitsAddition(const Limbs& lhs_bits,
+                                           const Limbs& rhs_bits) {
+    size_t lhs_sz = lhs_bits.size();
+    size_t rhs_sz = std::min(rhs_bits.size(), lhs_sz);
+    digits_.resize(lhs_sz + 1);
+
+    long long remainder =
+        std::is_constant_evaluated()
+            ? combine_limbs_scalar<false>(digits_.data(), lhs_bits.data(),
+                                          rhs_bits.data(), rhs_sz, 0)
+            : combine_limbs<false>(digits_.data(), lhs_bits.data(),
+                                   rhs_bits.data(), rhs_sz);
+    size_t i = rhs_sz;
+    for (; i < lhs_sz && remainder; ++i) {
+        long long next_digit = lhs_bits[i] + remainder;
+        remainder = next_digit >= kBase_;
+        digits_[i] = remainder ? next_digit - kBase_ : next_digit;
+    }
+    if (&lhs_bits != &digits_) {
+        std::copy(lhs_bits.begin() + static_cast<long>(i),
+                  lhs_bits.begin() + static_cast<long>(lhs_sz),
+                  digits_.begin() + static_cast<long>(i));
+    }
+    digits_[lhs_sz] = remainder;
+}
+
+constexpr BigInteger& BigInteger::operator+=(const BigInteger& rhs) {
+    if (is_small() && rhs.is_small()) {
+        set_small(small_value() + rhs.small_value());
+        return *this;
+    }
+    if (rhs.is_zero()) {
+        return *this;
+    }
+    if (is_negative_ != rhs.is_negative_) {
+        is_negative_ = !is_negative_;
+        *this -= (rhs);
+        delete_leading_zeroes();
+        if (is_zero())
+            is_negative_ = false;
+        else
+            is_negative_ = !is_negative_;
+        return *this;
+    }
+
+    bool is_sz_greater = digits_.size() > rhs.digits_.size();
+
+    if (is_sz_greater) {
+        digitsAddition(digits_, rhs.digits_);
+    }
+    else {
+        digitsAddition(rhs.digits_, digits_);
+    }
+
+    delete_leading_zeroes();
+    if (is_zero()) {
+        is_negative_ = false;
+    }
+    return *this;
+}
+
+constexpr BigInteger& BigInteger::operator*=(const BigInteger& rhs) {
+    if (is_small() && rhs.is_small()) {
+        long long high = split_wide(
+            static_cast<unsigned __int128>(digits_[0]) * rhs.digits_[0],
+            digits_[0]);
+        if (high != 0) {
+            digits_.push_back(high);
+        }
+        is_negative_ = !is_zero() && (is_negative_ != rhs.is_negative_);
+        return *this;
+    }
+    // The tuned tiers read mutable thresholds and may spawn threads, so
+    // constant evaluation stays with the schoolbook product.
+    if (std::is_constant_evaluated()) {
+        *this = schoolbook_multiplication(*this, rhs);
+    } else {
+        *this = multiply(*this, rhs);
+    }
+    delete_leading_zeroes();
+    return *this;
+}
+
+constexpr bool BigInteger::abs_less(const BigInteger& lhs,
+                                    const BigInteger& rhs) {
+    if (lhs.digits_.size() != rhs.digits_.size()) {
+        return lhs.digits_.size() < rhs.digits_.size();
+    }
+    for (size_t i = lhs.digits_.size(); i-- > 0;) {
+        if (lhs.digits_[i] != rhs.digits_[i]) {
+            return lhs.digits_[i] < rhs.digits_[i];
+        }
+    }
+    return false;
+}
+
+// Knuth's Algorithm D on magnitudes, both operands are normalized by d so
+// that the top limb of the divisor is at least kBase_ / 2.
+void BigInteger::knuth_division(const BigInteger& lhs, const BigInteger& rhs,
+                                BigInteger& quotient, BigInteger& remainder) {
+    size_t n = rhs.digits_.size();
+    size_t m = lhs.digits_.size() - n;
+    long long d = kBase_ / (rhs.digits_.back() + 1);
+
+    BigInteger u_number = lhs * d;
+    BigInteger v_number = rhs * d;
+    Limbs& u = u_number.digits_;
+    const Limbs& v = v_number.digits_;
+    u.resize(m + n + 1, 0);
+
+    quotient.is_negative_ = false;
+    quotient.digits_.assign(m + 1, 0);
+    for (size_t j = m + 1; j-- > 0;) {
+        unsigned __int128 numerator =
+            static_cast<unsigned __int128>(u[j + n]) * kBase_ + u[j + n - 1];
+        long long q_hat = static_cast<long long>(numerator / v[n - 1]);
+        long long r_hat = static_cast<long long>(
+            numerator - static_cast<unsigned __int128>(q_hat) * v[n - 1]);
+        while (q_hat >= kBase_ ||
+               (n > 1 && static_cast<unsigned __int128>(q_hat) * v[n - 2] >
+                             static_cast<unsigned __int128>(r_hat) * kBase_ +
+                                 u[j + n - 2])) {
+            --q_hat;
+            r_hat += v[n - 1];
+            if (r_hat >= kBase_) {
+                break;
+            }
+        }
+
+        long long carry = 0;
+        long long borrow = 0;
+        for (size_t i = 0; i < n; ++i) {
+            long long product_low;
+            carry = split_wide(
+                static_cast<unsigned __int128>(q_hat) * v[i] + carry,
+                product_low);
+            long long next_digit = u[i + j] - product_low - borrow;
+            borrow = next_digit < 0;
+            u[i + j] = next_digit + (borrow ? kBase_ : 0);
+        }
+        long long top = u[j + n] - carry - borrow;
+
+        if (top < 0) {
+            --q_hat;
+            carry = 0;
+            for (size_t i = 0; i < n; ++i) {
+                long long next_digit = u[i + j] + v[i] + carry;
+                carry = next_digit >= kBase_;
+                u[i + j] = next_digit - (carry ? kBase_ : 0);
+            }
+            top += carry;
+        }
+        u[j + n] = top;
+        quotient.digits_[j] = q_hat;
+    }
+    quotient.delete_leading_zeroes();
+
+    u.resize(n);
+    u_number.is_negative_ = false;
+    u_number.delete_leading_zeroes();
+    u_number.divmod_small(d);
+    remainder.swap(u_number);
+}
+
+// Approximation of kBase_^(2n) / divisor for an n-limb divisor, built by
+// Newton iterations that double the number of correct limbs.
+BigInteger BigInteger::reciprocal(const BigInteger& divisor) {
+    size_t n = divisor.digits_.size();
+    BigInteger power(1);
+    power.shift_digits(2 * n);
+    if (n < kReciprocalBorder_) {
+        BigInteger quotient;
+        BigInteger remainder;
+        knuth_division(power, divisor, quotient, remainder);
+        return quotient;
+    }
+
+    size_t kept_sz = n / 2 + 2;
+    BigInteger approximation =
+        reciprocal(digits_slice(divisor, n - kept_sz, n));
+    approximation.shift_digits(n - kept_sz);
+
+    BigInteger error = power - divisor * approximation;
+    BigInteger correction = approximation * error;
+    bool correction_is_neg = correction.is_negative_;
+    correction = digits_slice(correction, 2 * n, correction.digits_.size());
+    if (correction_is_neg) {
+        approximation -= correction;
+    } else {
+        approximation += correction;
+    }
+    return approximation;
+}
+
+// Divides the dividend block by block: every step is a division of at most
+// 2n limbs by the n-limb divisor through multiplication by its reciprocal.
+void BigInteger::newton_division(const BigInteger& lhs,
+                                 const BigInteger& rhs_signed,
+                                 BigInteger& quotient, BigInteger& remainder) {
+    BigInteger rhs(rhs_signed);
+    rhs.is_negative_ = false;
+    size_t n = rhs.digits_.size();
+    size_t blocks = (lhs.digits_.size() + n - 1) / n;
+    BigInteger inverse = reciprocal(rhs);
+
+    quotient.is_negative_ = false;
+    quotient.digits_.assign(blocks * n, 0);
+    BigInteger current(0);
+    for (size_t block = blocks; block-- > 0;) {
+        current.shift_digits(n);
+        current += digits_slice(lhs, block * n, (block + 1) * n);
+
+        BigInteger block_quotient = current * inverse;
+        block_quotient = digits_slice(block_quotient, 2 * n,
+                                      block_quotient.digits_.size());
+        current -= block_quotient * rhs;
+        while (current.is_negative_) {
+            --block_quotient;
+            current += rhs;
+        }
+        while (!abs_less(current, rhs)) {
+            ++block_quotient;
+            current -= rhs;
+        }
+        std::copy(block_quotient.digits_.begin(), block_quotient.digits_.end(),
+                  quotient.digits_.begin() + static_cast<long>(block * n));
+    }
+    quotient.delete_leading_zeroes();
+    remainder.swap(current);
+}
+
+std::pair<BigInteger, BigInteger> BigInteger::divmod(const BigInteger& lhs,
+                                                     const BigInteger& rhs) {
+    if (rhs.is_zero()) {
+        throw std::invalid_argument("BigInteger: division by zero");
+    }
+    BigInteger quotient;
+    BigInteger remainder;
+    if (abs_less(lhs, rhs)) {
+        quotient = 0;
+        remainder = lhs;
+        return {std::move(quotient), std::move(remainder)};
+    }
+
+    if (rhs.digits_.size() == 1) {
+        quotient = lhs;
+        quotient.is_negative_ = false;
+        remainder = quotient.divmod_small(rhs.digits_[0]);
+    } else if (rhs.digits_.size() < kNewtonDivisionBorder_) {
+        knuth_division(lhs, rhs, quotient, remainder);
+    } else {
+        newton_division(lhs, rhs, quotient, remainder);
+    }
+
+    if (!quotient.is_zero()) {
+        quotient.is_negative_ = lhs.is_negative_ ^ rhs.is_negative_;
+    }
+    if (!remainder.is_zero()) {
+        remainder.is_negative_ = lhs.is_negative_;
+    }
+    return {std::move(quotient), std::move(remainder)};
+}
+
+BigInteger& BigInteger::operator%=(const BigInteger& rhs) {
+    divmod(*this, rhs).second.swap(*this);
+    return *this;
+}
+
+BigInteger& BigInteger::operator/=(const BigInteger& rhs) {
+    divmod(*this, rhs).first.swap(*this);
+    return *this;
+}
+
+constexpr BigInteger BigInteger::operator*(long long x) const& {
+    BigInteger ans(*this);
+    return std::move(ans) * x;
+}
+
+constexpr BigInteger BigInteger::operator*(long long x) && {
+    mul_small(x);
+    return std::move(*this);
+}
+
+constexpr BigInteger& BigInteger::mul_small(long long x) {
+    bool x_is_neg = x < 0;
+    unsigned long long factor = x_is_neg ? 0ull - static_cast<unsigned long long>(x)
+                                         : static_cast<unsigned long long>(x);
+    unsigned __int128 carry = 0;
+    for (size_t i = 0; i < digits_.size(); ++i) {
+        carry = static_cast<unsigned long long>(split_wide(
+            static_cast<unsigned __int128>(digits_[i]) * factor + carry,
+            digits_[i]));
+    }
+    while (carry != 0) {
+        long long low;
+        carry = static_cast<unsigned long long>(split_wide(carry, low));
+        digits_.push_back(low);
+    }
+    delete_leading_zeroes();
+    is_negative_ = !is_zero() && (is_negative_ ^ x_is_neg);
+    return *this;
+}
+
+constexpr BigInteger& BigInteger::add_small(long long x) {
+    return addmul(1, x);
+}
+
+// The product is added to or subtracted from the magnitude limb by limb. A
+// subtraction that leaves a deficit past the top limb means the result
+// changed sign, and its magnitude is deficit * kBase_^n - limbs.
+constexpr BigInteger& BigInteger::addmul(const BigInteger& number,
+                                         long long x) {
+    if (number.is_zero() || x == 0) {
+        return *this;
+    }
+    bool product_is_neg = number.is_negative_ ^ (x < 0);
+    if (is_zero()) {
+        is_negative_ = product_is_neg;
+    }
+    bool subtract = is_negative_ != product_is_neg;
+    unsigned long long factor = x < 0 ? 0ull - static_cast<unsigned long long>(x)
+                                      : static_cast<unsigned long long>(x);
+
+    size_t sz = number.digits_.size();
+    if (digits_.size() < sz) {
+        digits_.resize(sz);
+    }
+    unsigned __int128 carry = 0;
+    if (!subtract) {
+        for (size_t i = 0; i < sz; ++i) {
+            carry = static_cast<unsigned long long>(split_wide(
+                static_cast<unsigned __int128>(number.digits_[i]) * factor +
+                    digits_[i] + carry,
+                digits_[i]));
+        }
+        for (size_t i = sz; carry != 0; ++i) {
+            if (i == digits_.size()) {
+                digits_.push_back(0);
+            }
+            carry = static_cast<unsigned long long>(
+                split_wide(carry + digits_[i], digits_[i]));
+        }
+        return *this;
+    }
+
+    for (size_t i = 0; i < digits_.size() && (i < sz || carry != 0); ++i) {
+        long long low;
+        unsigned __int128 product =
+            i < sz ? static_cast<unsigned __int128>(number.digits_[i]) * factor
+                   : 0;
+        carry = static_cast<unsigned long long>(split_wide(product + carry, low));
+        long long next_digit = digits_[i] - low;
+        if (next_digit < 0) {
+            next_digit += kBase_;
+            ++carry;
+        }
+        digits_[i] = next_digit;
+    }
+    if (carry != 0) {
+        long long borrow = 0;
+        for (size_t i = 0; i < digits_.size(); ++i) {
+            long long next_digit = -digits_[i] - borrow;
+            borrow = next_digit < 0;
+            digits_[i] = borrow ? next_digit + kBase_ : next_digit;
+        }
+        carry -= borrow;
+        while (carry != 0) {
+            long long low;
+            carry = static_cast<unsigned long long>(split_wide(carry, low));
+            digits_.push_back(low);
+        }
+        is_negative_ = !is_negative_;
+    }
+    delete_leading_zeroes();
+    if (is_zero()) {
+        is_negative_ = false;
+    }
+    return *this;
+}
+
+constexpr BigInteger& BigInteger::operator++() {
+    *this += 1;
+    return *this;
+}
+
+constexpr BigInteger& BigInteger::operator--() {
+    *this -= 1;
+    return *this;
+}
+
+constexpr BigInteger BigInteger::operator++(int) & {
+    BigInteger ans(*this);
+    *this += 1;
+    return ans;
+}
+
+constexpr BigInteger BigInteger::operator--(int) & {
+    BigInteger ans(*this);
+    *this -= 1;
+    return ans;
+}
+
+constexpr std::strong_ordering operator<=>(const BigInteger& lhs,
+                                           const BigInteger& rhs) {
+    if (lhs.is_negative_ != rhs.is_negative_) {
+        return (lhs.is_negative_ > rhs.is_negative_)
+                   ? std::strong_ordering::less
+                   : std::strong_ordering::greater;
+    }
+    bool sign = lhs.is_negative_;
+    if (lhs.digits_.size() != rhs.digits_.size()) {
+        bool unsigned_less = lhs.digits_.size() < rhs.digits_.size();
+        return (unsigned_less ^ sign) ? std::strong_ordering::less
+                                      : std::strong_ordering::greater;
+    }
+
+    bool equal = true;
+    bool is_less_unsigned;
+    size_t idx = (lhs.digits_.size());
+    while (idx) {
+        idx--;
+        if (lhs.digits_[idx] != rhs.digits_[idx]) {
+            is_less_unsigned = (lhs.digits_[idx] < rhs.digits_[idx]);
+            equal = false;
+            break;
+        }
+    }
+    if (equal) {
+        return std::strong_ordering::equal;
+    }
+    return is_less_unsigned ^ sign ? std::strong_ordering::less
+                                   : std::strong_ordering::greater;
+}
+
+// Digits are taken straight from the stream buffer. Every full group of
+// kCharsInDigits digits becomes a limb (most significant first, reversed at
+// the end), and the last partial group of r digits is merged in by
+// multiplying by 10^r.
+std::istream& operator>>(std::istream& input, BigInteger& rhs) {
+    std::istream::sentry sentry(input);
+    if (!sentry) {
+        return input;
+    }
+    std::streambuf* buffer = input.rdbuf();
+    int ch = buffer->sgetc();
+    bool is_negative = ch == '-';
+    if (is_negative) {
+        ch = buffer->snextc();
+    }
+
+    rhs.digits_.resize(0);
+    long long group = 0;
+    long long group_size = 0;
+    bool has_digits = false;
+    while (ch >= '0' && ch <= '9') {
+        has_digits = true;
+        group = group * 10 + (ch - '0');
+        if (++group_size == BigInteger::kCharsInDigits) {
+            rhs.digits_.push_back(group);
+            group = 0;
+            group_size = 0;
+        }
+        ch = buffer->snextc();
+    }
+    if (ch == std::char_traits<char>::eof()) {
+        input.setstate(std::ios_base::eofbit);
+    }
+    if (!has_digits) {
+        rhs.set_small(0);
+        input.setstate(std::ios_base::failbit);
+        return input;
+    }
+
+    rhs.is_negative_ = false;
+    if (rhs.digits_.empty()) {
+        rhs.digits_.push_back(group);
+    } else {
+        std::reverse(rhs.digits_.begin(), rhs.digits_.end());
+        if (group_size != 0) {
+            long long scale = 1;
+            for (long long i = 0; i < group_size; ++i) {
+                scale *= 10;
+            }
+            rhs.mul_small(scale).add_small(group);
+        }
+    }
+    rhs.delete_leading_zeroes();
+    rhs.is_negative_ = is_negative && !rhs.is_zero();
+    return input;
+}
+
+const char* BigInteger::from_chars(const char* first, const char* last,
+                                   BigInteger& value) {
+    const char* end = first;
+    if (end != last && *end == '-') {
+        ++end;
+    }
+    const char* digits_begin = end;
+    while (end != last && *end >= '0' && *end <= '9') {
+        ++end;
+    }
+    if (end == digits_begin) {
+        throw std::invalid_argument("BigInteger::from_chars: no digits");
+    }
+    value.parse(first, static_cast<size_t>(end - first));
+    return end;
+}
+
+size_t BigInteger::read_batch(const char* first, const char* last,
+                              std::vector<BigInteger>& values) {
+    size_t count = 0;
+    while (true) {
+        while (first != last &&
+               std::isspace(static_cast<unsigned char>(*first))) {
+            ++first;
+        }
+        if (first == last) {
+            break;
+        }
+        if (count == values.size()) {
+            values.emplace_back();
+        }
+        try {
+            first = from_chars(first, last, values[count]);
+        } catch (const std::invalid_argument&) {
+            first = nullptr;
+        }
+        if (first == nullptr ||
+            (first != last &&
+             !std::isspace(static_cast<unsigned char>(*first)))) {
+            values.resize(count);
+            throw std::invalid_argument("BigInteger: malformed number");
+        }
+        ++count;
+    }
+    values.resize(count);
+    return count;
+}
+
+size_t BigInteger::read_batch(std::istream& input,
+                              std::vector<BigInteger>& values) {
+    size_t count = 0;
+    while (!(input >> std::ws).eof()) {
+        if (count == values.size()) {
+            values.emplace_back();
+        }
+        if (!(input >> values[count])) {
+            break;
+        }
+        int next = input.peek();
+        if (next != std::char_traits<char>::eof() && !std::isspace(next)) {
+            input.setstate(std::ios_base::failbit);
+            break;
+        }
+        ++count;
+    }
+    values.resize(count);
+    return count;
+}
+
+void BigInteger::store_word(unsigned long long word, char* out) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<char>(word >> (8 * i));
+    }
+}
+
+unsigned long long BigInteger::load_word(const char* in) {
+    unsigned long long word = 0;
+    for (int i = 0; i < 8; ++i) {
+        word |= static_cast<unsigned long long>(static_cast<unsigned char>(
+                    in[i]))
+                << (8 * i);
+    }
+    return word;
+}
+
+void BigInteger::check_binary_value() const {
+    for (long long limb : digits_) {
+        if (limb < 0 || limb >= kBase_) {
+            throw std::invalid_argument("BigInteger: malformed binary limb");
+        }
+    }
+    if ((digits_.size() > 1 && digits_.back() == 0) ||
+        (is_negative_ && is_zero())) {
+        throw std::invalid_argument("BigInteger: unnormalized binary value");
+    }
+}
+
+size_t BigInteger::binary_size() const {
+    return 8 * (digits_.size() + 1);
+}
+
+char* BigInteger::to_binary(char* out) const {
+    store_word((static_cast<unsigned long long>(digits_.size()) << 1) |
+                   static_cast<unsigned long long>(is_negative_),
+               out);
+    out += 8;
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(out, digits_.data(), digits_.size() * 8);
+        return out + digits_.size() * 8;
+    } else {
+        for (long long limb : digits_) {
+            store_word(static_cast<unsigned long long>(limb), out);
+            out += 8;
+        }
+        return out;
+    }
+}
+
+const char* BigInteger::from_binary(const char* first, const char* last,
+                                    BigInteger& value) {
+    size_t available = static_cast<size_t>(last - first) / 8;
+    if (available == 0) {
+        throw std::invalid_argument("BigInteger: truncated binary value");
+    }
+    unsigned long long header = load_word(first);
+    unsigned long long count = header >> 1;
+    if (count == 0 || count > available - 1) {
+        throw std::invalid_argument("BigInteger: truncated binary value");
+    }
+    BigInteger decoded;
+    decoded.is_negative_ = (header & 1) != 0;
+    decoded.digits_.resize(count);
+    first += 8;
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(decoded.digits_.data(), first, count * 8);
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            decoded.digits_[i] =
+                static_cast<long long>(load_word(first + 8 * i));
+        }
+    }
+    decoded.check_binary_value();
+    value = std::move(decoded);
+    return first + 8 * count;
+}
+
+void BigInteger::write_binary(std::ostream& output) const {
+    char header[8];
+    store_word((static_cast<unsigned long long>(digits_.size()) << 1) |
+                   static_cast<unsigned long long>(is_negative_),
+               header);
+    output.write(header, 8);
+    if constexpr (std::endian::native == std::endian::little) {
+        output.write(reinterpret_cast<const char*>(digits_.data()),
+                     static_cast<std::streamsize>(digits_.size() * 8));
+    } else {
+        for (long long limb : digits_) {
+            store_word(static_cast<unsigned long long>(limb), header);
+            output.write(header, 8);
+        }
+    }
+}
+
+// The limbs are read in chunks of kBinaryChunkLimbs_ and reach value only
+// once they check out.
+void BigInteger::read_binary(std::istream& input, BigInteger& value) {
+    char header[8];
+    if (!input.read(header, 8)) {
+        throw std::invalid_argument("BigInteger: truncated binary value");
+    }
+    unsigned long long count = load_word(header) >> 1;
+    if (count == 0 || count > std::numeric_limits<size_t>::max() / 16) {
+        throw std::invalid_argument("BigInteger: malformed binary value");
+    }
+    BigInteger decoded;
+    decoded.is_negative_ = (load_word(header) & 1) != 0;
+    decoded.digits_.resize(0);
+    for (size_t done = 0; done < count;) {
+        size_t chunk = std::min<size_t>(count - done, kBinaryChunkLimbs_);
+        decoded.digits_.resize(done + chunk);
+        if (!input.read(
+                reinterpret_cast<char*>(decoded.digits_.data() + done),
+                static_cast<std::streamsize>(chunk * 8))) {
+            throw std::invalid_argument("BigInteger: truncated binary value");
+        }
+        done += chunk;
+    }
+    if constexpr (std::endian::native != std::endian::little) {
+        for (long long& limb : decoded.digits_) {
+            limb = static_cast<long long>(
+                load_word(reinterpret_cast<const char*>(&limb)));
+        }
+    }
+    decoded.check_binary_value();
+    value = std::move(decoded);
+}
+
+void BigInteger::write_binary(std::ostream& output,
+                              const std::vector<BigInteger>& values) {
+    write_array(output, values, kBinaryIntegerKind_);
+}
+
+void BigInteger::read_binary(std::istream& input,
+                             std::vector<BigInteger>& values) {
+    read_array(input, values, kBinaryIntegerKind_);
+}
+
+const char* BigInteger::read_binary(const char* first, const char* last,
+                                    std::vector<BigInteger>& values) {
+    return read_array(first, last, values, kBinaryIntegerKind_);
+}
+
+template <typename Value>
+void BigInteger::write_array(std::ostream& output,
+                             const std::vector<Value>& values, unsigned kind) {
+    char header[16] = {'B', 'I', 'G', 'N'};
+    header[4] = static_cast<char>(kBinaryVersion);
+    header[5] = static_cast<char>(kBinaryVersion >> 8);
+    header[6] = static_cast<char>(kind);
+    store_word(values.size(), header + 8);
+    output.write(header, 16);
+    for (const Value& value : values) {
+        value.write_binary(output);
+    }
+}
+
+// Checks the 16-byte array header and returns the element count.
+unsigned long long BigInteger::read_array_header(const char* header,
+                                                 unsigned kind) {
+    unsigned version =
+        static_cast<unsigned char>(header[4]) |
+        (static_cast<unsigned>(static_cast<unsigned char>(header[5])) << 8);
+    if (std::memcmp(header, "BIGN", 4) != 0 ||
+        static_cast<unsigned char>(header[6]) != kind || header[7] != 0) {
+        throw std::invalid_argument("BigInteger: not a binary array");
+    }
+    if (version != kBinaryVersion) {
+        throw std::invalid_argument("BigInteger: unsupported binary version");
+    }
+    return load_word(header + 8);
+}
+
+template <typename Value>
+void BigInteger::read_array(std::istream& input, std::vector<Value>& values,
+                            unsigned kind) {
+    char header[16];
+    if (!input.read(header, 16)) {
+        throw std::invalid_argument("BigInteger: truncated binary array");
+    }
+    unsigned long long count = read_array_header(header, kind);
+    // Nothing is reserved up front: values are appended as they are read.
+    values.clear();
+    for (unsigned long long i = 0; i < count; ++i) {
+        values.emplace_back();
+        Value::read_binary(input, values.back());
+    }
+}
+
+template <typename Value>
+const char* BigInteger::read_array(const char* first, const char* last,
+                                   std::vector<Value>& values, unsigned kind) {
+    if (last - first < 16) {
+        throw std::invalid_argument("BigInteger: truncated binary array");
+    }
+    unsigned long long count = read_array_header(first, kind);
+    first += 16;
+    // Every value takes at least 16 bytes, which bounds a corrupt count.
+    if (count > static_cast<unsigned long long>(last - first) / 16) {
+        throw std::invalid_argument("BigInteger: truncated binary array");
+    }
+    values.resize(count);
+    for (Value& value : values) {
+        first = Value::from_binary(first, last, value);
+    }
+    return first;
+}
+
+std::ostream& operator<<(std::ostream& output, const BigInteger& rhs) {
+    output << rhs.toString();
+    return output;
+}
+
+// Decimal digits with an optional leading '-' and digit separators, any
+// other character fails the constant evaluation.
+template <size_t Capacity>
+constexpr BigInteger::LiteralValue<Capacity> BigInteger::parse_literal(
+    const char* str, size_t str_size) {
+    LiteralValue<Capacity> value;
+    size_t start = 0;
+    if (str_size && str[0] == '-') {
+        value.is_negative = true;
+        start = 1;
+    }
+    long long power = 1;
+    size_t limb = 0;
+    for (size_t i = str_size; i-- > start;) {
+        if (str[i] == '\'') {
+            continue;
+        }
+        if (str[i] < '0' || str[i] > '9') {
+            throw std::invalid_argument("_bi: not a decimal literal");
+        }
+        if (power == kBase_) {
+            power = 1;
+            ++limb;
+        }
+        value.limbs[limb] += (str[i] - '0') * power;
+        power *= 10;
+    }
+    value.size = limb + 1;
+    while (value.size > 1 && value.limbs[value.size - 1] == 0) {
+        --value.size;
+    }
+    if (value.size == 1 && value.limbs[0] == 0) {
+        value.is_negative = false;
+    }
+    return value;
+}
+
+template <size_t Capacity>
+constexpr BigInteger::BigInteger(const LiteralValue<Capacity>& value)
+    : is_negative_(value.is_negative) {
+    digits_.assign(value.limbs.data(), value.limbs.data() + value.size);
+}
+
+// The parsed limbs are constants, so evaluating a literal only copies them.
+template <char... Digits>
+constexpr BigInteger operator""_bi() {
+    constexpr size_t kCapacity =
+        sizeof...(Digits) / BigInteger::kCharsInDigits + 1;
+    constexpr std::array<char, sizeof...(Digits)> kChars = {Digits...};
+    constexpr BigInteger::LiteralValue<kCapacity> kValue =
+        BigInteger::parse_literal<kCapacity>(kChars.data(), kChars.size());
+    return BigInteger(kValue);
+}
+
+template <BigInteger::Literal Str>
+constexpr BigInteger operator""_bi() {
+    constexpr size_t kSize = sizeof(Str.chars) - 1;
+    constexpr size_t kCapacity = kSize / BigInteger::kCharsInDigits + 1;
+    constexpr BigInteger::LiteralValue<kCapacity> kValue =
+        BigInteger::parse_literal<kCapacity>(Str.chars, kSize);
+    return BigInteger(kValue);
+}
+
+// The output is written right to left into a buffer of the exact length:
+// every limb but the top one takes exactly kCharsInDigits characters.
+std::string BigInteger::toString() const {
+    if (is_zero()) {
+        return "0";
+    }
+    size_t top_sz = 0;
+    for (long long top = digits_.back(); top != 0; top /= 10) {
+        ++top_sz;
+    }
+    size_t sign_sz = is_negative_ ? 1 : 0;
+    std::string ans(sign_sz + top_sz +
+                        static_cast<size_t>(kCharsInDigits) *
+                            (digits_.size() - 1),
+                    '0');
+
+    char* cur = ans.data() + ans.size();
+    for (size_t i = 0; i + 1 < digits_.size(); ++i) {
+        long long x = digits_[i];
+        for (long long j = 0; j < kCharsInDigits; ++j) {
+            *--cur = static_cast<char>(x % 10 + '0');
+            x /= 10;
+        }
+    }
+    for (long long x = digits_.back(); x != 0; x /= 10) {
+        *--cur = static_cast<char>(x % 10 + '0');
+    }
+    if (is_negative_) {
+        ans[0] = '-';
+    }
+    return ans;
+}
+
+BigInteger::operator bool() {
+    return !is_zero();
+}
+
+unsigned long long BigInteger::binary_gcd(unsigned long long lhs,
+                                          unsigned long long rhs) {
+    if (lhs == 0 || rhs == 0) {
+        return lhs | rhs;
+    }
+    int shift = std::countr_zero(lhs | rhs);
+    lhs >>= std::countr_zero(lhs);
+    while (rhs != 0) {
+        rhs >>= std::countr_zero(rhs);
+        if (lhs > rhs) {
+            std::swap(lhs, rhs);
+        }
+        rhs -= lhs;
+    }
+    return lhs << shift;
+}
+
+// Knuth's Algorithm L: runs Euclid on the leading 18 digits of u and v and
+// collects the cofactors {A, B, C, D} while the quotients are certain.
+// Returns false when no step could be taken.
+bool BigInteger::lehmer_cofactors(const BigInteger& u, const BigInteger& v,
+                                  long long (&cofactors)[4]) {
+    const Limbs& u_bits = u.digits_;
+    const Limbs& v_bits = v.digits_;
+    size_t n = u_bits.size();
+    auto limb = [](const Limbs& bits, size_t idx) {
+        return idx < bits.size() ? bits[idx] : 0LL;
+    };
+    unsigned __int128 u_top =
+        static_cast<unsigned __int128>(u_bits[n - 1]) * kBase_ + u_bits[n - 2];
+    unsigned __int128 v_top =
+        static_cast<unsigned __int128>(limb(v_bits, n - 1)) * kBase_ +
+        limb(v_bits, n - 2);
+    unsigned long long scale = 1;
+    for (long long top = u_bits[n - 1]; top != 0; top /= 10) {
+        scale *= 10;
+    }
+    long long u_hat = static_cast<long long>(u_top / scale);
+    long long v_hat = static_cast<long long>(v_top / scale);
+
+    long long a = 1, b = 0, c = 0, d = 1;
+    while (v_hat + c != 0 && v_hat + d != 0) {
+        long long q = (u_hat + a) / (v_hat + c);
+        if (q != (u_hat + b) / (v_hat + d)) {
+            break;
+        }
+        long long t = a - q * c;
+        a = c;
+        c = t;
+        t = b - q * d;
+        b = d;
+        d = t;
+        t = u_hat - q * v_hat;
+        u_hat = v_hat;
+        v_hat = t;
+    }
+    cofactors[0] = a;
+    cofactors[1] = b;
+    cofactors[2] = c;
+    cofactors[3] = d;
+    return b != 0;
+}
+
+// result = x * x_coef + y * y_coef for |coefficients| < kBase_ of opposite
+// signs whose combination is known to be nonnegative.
+void BigInteger::linear_combination(const BigInteger& x, long long x_coef,
+                                    const BigInteger& y, long long y_coef,
+                                    BigInteger& result) {
+    size_t sz = std::max(x.digits_.size(), y.digits_.size());
+    result.is_negative_ = false;
+    result.digits_.resize(sz);
+    unsigned long long x_abs = x_coef < 0 ? -x_coef : x_coef;
+    unsigned long long y_abs = y_coef < 0 ? -y_coef : y_coef;
+    long long carry = 0;
+    for (size_t i = 0; i < sz; ++i) {
+        long long x_low = 0, y_low = 0;
+        long long x_high = split_wide(
+            static_cast<unsigned __int128>(
+                i < x.digits_.size() ? x.digits_[i] : 0) * x_abs,
+            x_low);
+        long long y_high = split_wide(
+            static_cast<unsigned __int128>(
+                i < y.digits_.size() ? y.digits_[i] : 0) * y_abs,
+            y_low);
+        if (x_coef < 0) {
+            x_low = -x_low;
+            x_high = -x_high;
+        }
+        if (y_coef < 0) {
+            y_low = -y_low;
+            y_high = -y_high;
+        }
+        long long low = x_low + y_low + carry;
+        carry = x_high + y_high;
+        while (low < 0) {
+            low += kBase_;
+            --carry;
+        }
+        while (low >= kBase_) {
+            low -= kBase_;
+            ++carry;
+        }
+        result.digits_[i] = low;
+    }
+    result.delete_leading_zeroes();
+}
+
+// Lehmer's GCD of nonnegative u >= v. While both values have several limbs
+// a whole batch of Euclid steps is applied at once as a 2x2 cofactor matrix;
+// a full division is done only when the leading digits cannot decide the
+// quotient. The single-limb tail goes to binary GCD. If u_cofactor is set,
+// it receives s with s * u = gcd (mod v) for the original arguments.
+BigInteger BigInteger::lehmer_gcd(BigInteger u, BigInteger v,
+                                  BigInteger* u_cofactor) {
+    BigInteger s0(1);
+    BigInteger s1(0);
+    BigInteger next_u;
+    BigInteger next_v;
+    bool track = u_cofactor != nullptr;
+    while (!v.is_zero() && (track || v.digits_.size() > 1)) {
+        long long cofactors[4];
+        if (u.digits_.size() > 1 && lehmer_cofactors(u, v, cofactors)) {
+            linear_combination(u, cofactors[0], v, cofactors[1], next_u);
+            linear_combination(u, cofactors[2], v, cofactors[3], next_v);
+            u.swap(next_u);
+            v.swap(next_v);
+            if (track) {
+                BigInteger next_s0 = s0 * cofactors[0];
+                next_s0.addmul(s1, cofactors[1]);
+                s1.mul_small(cofactors[3]).addmul(s0, cofactors[2]);
+                s0.swap(next_s0);
+            }
+            continue;
+        }
+
+        std::pair<BigInteger, BigInteger> division = divmod(u, v);
+        u.swap(v);
+        v.swap(division.second);
+        if (track) {
+            s0 -= division.first * s1;
+            s0.swap(s1);
+        }
+    }
+
+    if (track) {
+        u_cofactor->swap(s0);
+        return u;
+    }
+    if (v.is_zero()) {
+        return u;
+    }
+    unsigned long long tail = static_cast<unsigned long long>(
+        u.divmod_small(v.digits_[0]));
+    return static_cast<long long>(
+        binary_gcd(static_cast<unsigned long long>(v.digits_[0]), tail));
+}
+
+BigInteger BigInteger::gcd(const BigInteger& a, const BigInteger& b) {
+    BigInteger u(a);
+    BigInteger v(b);
+    u.is_negative_ = false;
+    v.is_negative_ = false;
+    if (abs_less(u, v)) {
+        u.swap(v);
+    }
+    return lehmer_gcd(std::move(u), std::move(v), nullptr);
+}
+
+BigInteger BigInteger::extended_gcd(const BigInteger& a, const BigInteger& b,
+                                    BigInteger& x, BigInteger& y) {
+    BigInteger u(a);
+    BigInteger v(b);
+    u.is_negative_ = false;
+    v.is_negative_ = false;
+    bool swapped = abs_less(u, v);
+    if (swapped) {
+        u.swap(v);
+    }
+
+    BigInteger cofactor;
+    BigInteger g = lehmer_gcd(u, v, &cofactor);
+    const BigInteger& first = swapped ? b : a;
+    const BigInteger& second = swapped ? a : b;
+    if (first.is_negative_) {
+        cofactor = -cofactor;
+    }
+    BigInteger other = second.is_zero() ? BigInteger(0)
+                                        : (g - first * cofactor) / second;
+    if (swapped) {
+        x.swap(other);
+        y.swap(cofactor);
+    } else {
+        x.swap(cofactor);
+        y.swap(other);
+    }
+    return g;
+}
+
+// Fixed divisor with a precomputed Barrett reciprocal mu ~ kBase_^(2n) / m
+// for an n-limb m: dividends of up to 2n limbs are divided by two products
+// of about n limbs and at most a few corrections, with the same truncating
+// semantics as BigInteger::divmod. Longer dividends, and divisors below
+// kBarrettBorder_ limbs where Knuth's division is faster, go to divmod.
+class BigInteger::Divisor {
+    BigInteger divisor_;
+    BigInteger reciprocal_;
+    bool is_negative_ = false;
+
+  public:
+    explicit Divisor(const BigInteger&);
+
+    BigInteger value() const {
+        return is_negative_ ? -divisor_ : divisor_;
+    }
+
+    std::pair<BigInteger, BigInteger> divmod(const BigInteger&) const;
+    BigInteger mod(const BigInteger&) const;
+};
+
+BigInteger::Divisor::Divisor(const BigInteger& divisor)
+    : divisor_(divisor), is_negative_(divisor.is_negative_) {
+    divisor_.is_negative_ = false;
+    if (divisor_.is_zero()) {
+        throw std::invalid_argument("Divisor: division by zero");
+    }
+    if (divisor_.digits_.size() >= kBarrettBorder_) {
+        reciprocal_ = reciprocal(divisor_);
+    }
+}
+
+std::pair<BigInteger, BigInteger> BigInteger::Divisor::divmod(
+    const BigInteger& dividend) const {
+    size_t n = divisor_.digits_.size();
+    if (n < kBarrettBorder_ || dividend.digits_.size() > 2 * n) {
+        return BigInteger::divmod(dividend, value());
+    }
+    if (abs_less(dividend, divisor_)) {
+        return {0, dividend};
+    }
+
+    BigInteger remainder(dividend);
+    remainder.is_negative_ = false;
+    BigInteger quotient =
+        digits_slice(remainder, n - 1, remainder.digits_.size()) * reciprocal_;
+    quotient = digits_slice(quotient, n + 1, quotient.digits_.size());
+    remainder -= quotient * divisor_;
+    while (remainder.is_negative_) {
+        --quotient;
+        remainder += divisor_;
+    }
+    while (!abs_less(remainder, divisor_)) {
+        ++quotient;
+        remainder -= divisor_;
+    }
+
+    if (!quotient.is_zero()) {
+        quotient.is_negative_ = dividend.is_negative_ ^ is_negative_;
+    }
+    if (!remainder.is_zero()) {
+        remainder.is_negative_ = dividend.is_negative_;
+    }
+    return {std::move(quotient), std::move(remainder)};
+}
+
+BigInteger BigInteger::Divisor::mod(const BigInteger& dividend) const {
+    return divmod(dividend).second;
+}
+
+// Montgomery arithmetic modulo a fixed m coprime to the base, with
+// R = kBase_^n for an n-limb m: products are reduced by REDC, so
+// exponentiation needs no division after the setup.
+class BigInteger::MontgomeryContext {
+    BigInteger modulus_;
+    BigInteger r_squared_;
+    long long inverse_ = 0;
+
+  public:
+    explicit MontgomeryContext(const BigInteger&);
+
+    const BigInteger& modulus() const {
+        return modulus_;
+    }
+
+    BigInteger to_montgomery(const BigInteger&) const;
+    BigInteger from_montgomery(const BigInteger&) const;
+    // Montgomery product lhs * rhs / R mod m of two reduced values.
+    BigInteger multiply(const BigInteger&, const BigInteger&) const;
+    BigInteger pow(const BigInteger&, const BigInteger&) const;
+};
+
+BigInteger::MontgomeryContext::MontgomeryContext(const BigInteger& modulus)
+    : modulus_(modulus) {
+    modulus_.is_negative_ = false;
+    long long low = modulus_.digits_[0];
+    if (low % 2 == 0 || low % 5 == 0) {
+        throw std::invalid_argument(
+            "MontgomeryContext: modulus must be coprime to 10");
+    }
+
+    long long old_r = low, r = kBase_;
+    long long old_s = 1, s = 0;
+    while (r != 0) {
+        long long q = old_r / r;
+        long long t = old_r - q * r;
+        old_r = r;
+        r = t;
+        t = old_s - q * s;
+        old_s = s;
+        s = t;
+    }
+    long long inverse = old_s < 0 ? old_s + kBase_ : old_s;
+    inverse_ = inverse == 0 ? 0 : kBase_ - inverse;
+
+    r_squared_ = 1;
+    r_squared_.shift_digits(2 * modulus_.digits_.size());
+    r_squared_ %= modulus_;
+}
+
+// Coarsely integrated operand scanning: every outer step adds lhs[i] * rhs
+// and then cancels the lowest limb with a multiple of m, dropping it.
+BigInteger BigInteger::MontgomeryContext::multiply(const BigInteger& lhs,
+                                                   const BigInteger& rhs) const {
+    const Limbs& m = modulus_.digits_;
+    const Limbs& rhs_bits = rhs.digits_;
+    size_t n = m.size();
+    BigInteger result;
+    Limbs& t = result.digits_;
+    t.assign(n + 2, 0);
+
+    for (size_t i = 0; i < n; ++i) {
+        long long lhs_limb = i < lhs.digits_.size() ? lhs.digits_[i] : 0;
+        long long carry = 0;
+        if (lhs_limb != 0) {
+            for (size_t j = 0; j < rhs_bits.size(); ++j) {
+                carry = split_wide(
+                    static_cast<unsigned __int128>(lhs_limb) * rhs_bits[j] +
+                        t[j] + carry,
+                    t[j]);
+            }
+            for (size_t j = rhs_bits.size(); carry != 0; ++j) {
+                long long next_digit = t[j] + carry;
+                carry = next_digit >= kBase_;
+                t[j] = carry ? next_digit - kBase_ : next_digit;
+            }
+        }
+
+        long long factor;
+        split_wide(static_cast<unsigned __int128>(t[0]) * inverse_, factor);
+        long long dropped;
+        carry = split_wide(
+            static_cast<unsigned __int128>(factor) * m[0] + t[0], dropped);
+        for (size_t j = 1; j < n; ++j) {
+            carry = split_wide(
+                static_cast<unsigned __int128>(factor) * m[j] + t[j] + carry,
+                t[j - 1]);
+        }
+        long long next_digit = t[n] + carry;
+        carry = next_digit >= kBase_;
+        t[n - 1] = carry ? next_digit - kBase_ : next_digit;
+        t[n] = t[n + 1] + carry;
+        t[n + 1] = 0;
+    }
+
+    result.delete_leading_zeroes();
+    if (!abs_less(result, modulus_)) {
+        result -= modulus_;
+    }
+    return result;
+}
+
+BigInteger BigInteger::MontgomeryContext::to_montgomery(
+    const BigInteger& number) const {
+    BigInteger reduced = number % modulus_;
+    if (reduced.is_negative_) {
+        reduced += modulus_;
+    }
+    return multiply(reduced, r_squared_);
+}
+
+BigInteger BigInteger::MontgomeryContext::from_montgomery(
+    const BigInteger& number) const {
+    return multiply(number, 1);
+}
+
+BigInteger BigInteger::MontgomeryContext::pow(
+    const BigInteger& base, const BigInteger& exponent) const {
+    BigInteger result = sliding_window_pow(
+        to_montgomery(base), exponent, to_montgomery(1),
+        [this](const BigInteger& lhs, const BigInteger& rhs) {
+            return multiply(lhs, rhs);
+        });
+    return from_montgomery(result);
+}
+
+// Left-to-right sliding window exponentiation over the binary digits of the
+// exponent: only odd powers of base up to 2^window are precomputed.
+template <typename Multiply>
+BigInteger BigInteger::sliding_window_pow(const BigInteger& base,
+                                          const BigInteger& exponent,
+                                          const BigInteger& one,
+                                          Multiply multiply) {
+    if (exponent.is_negative_) {
+        throw std::invalid_argument("powmod: negative exponent");
+    }
+    const int kWordBits = 62;
+    std::vector<unsigned long long> words;
+    BigInteger rest(exponent);
+    while (!rest.is_zero()) {
+        words.push_back(
+            static_cast<unsigned long long>(rest.divmod_small(1LL << kWordBits)));
+    }
+    if (words.empty()) {
+        return one;
+    }
+    auto bit = [&words, kWordBits](size_t idx) {
+        return (words[idx / kWordBits] >> (idx % kWordBits)) & 1;
+    };
+    size_t bits_count = kWordBits * (words.size() - 1) +
+                        static_cast<size_t>(std::bit_width(words.back()));
+
+    size_t window = bits_count > 768 ? 5 : bits_count > 192 ? 4
+                    : bits_count > 24  ? 3
+                                       : 1;
+    std::vector<BigInteger> odd_powers(size_t(1) << (window - 1));
+    odd_powers[0] = base;
+    if (window > 1) {
+        BigInteger base_squared = multiply(base, base);
+        for (size_t i = 1; i < odd_powers.size(); ++i) {
+            odd_powers[i] = multiply(odd_powers[i - 1], base_squared);
+        }
+    }
+
+    BigInteger result = one;
+    bool started = false;
+    for (size_t i = bits_count; i-- > 0;) {
+        if (!bit(i)) {
+            if (started) {
+                result = multiply(result, result);
+            }
+            continue;
+        }
+        size_t low = i + 1 >= window ? i + 1 - window : 0;
+        while (!bit(low)) {
+            ++low;
+        }
+        size_t value = 0;
+        for (size_t j = i + 1; j-- > low;) {
+            value = value * 2 + bit(j);
+            if (started) {
+                result = multiply(result, result);
+            }
+        }
+        result = started ? multiply(result, odd_powers[value / 2])
+                         : odd_powers[value / 2];
+        started = true;
+        i = low;
+    }
+    return result;
+}
+
+BigInteger BigInteger::powmod(const BigInteger& base,
+                              const BigInteger& exponent,
+                              const BigInteger& modulus_signed) {
+    BigInteger modulus(modulus_signed);
+    modulus.is_negative_ = false;
+    if (modulus.is_zero()) {
+        throw std::invalid_argument("powmod: zero modulus");
+    }
+    if (modulus == 1) {
+        return 0;
+    }
+    long long low = modulus.digits_[0];
+    if (low % 2 != 0 && low % 5 != 0) {
+        return MontgomeryContext(modulus).pow(base, exponent);
+    }
+
+    Divisor divisor(modulus);
+    BigInteger reduced = base % modulus;
+    if (reduced.is_negative_) {
+        reduced += modulus;
+    }
+    return sliding_window_pow(reduced, exponent, 1,
+                              [&divisor](const BigInteger& lhs,
+                                         const BigInteger& rhs) {
+                                  return divisor.mod(lhs * rhs);
+                              });
+}
+
+// Multiplies values[from, to) splitting the range in halves, so the
+// operands at every level have similar sizes. limbs_prefix holds prefix sums
+// of the value sizes when the parallel mode is on and is empty otherwise.
+BigInteger BigInteger::product_tree(const std::vector<BigInteger>& values,
+                                    const std::vector<size_t>& limbs_prefix,
+                                    size_t from, size_t to, size_t depth) {
+    if (to - from == 1) {
+        return values[from];
+    }
+    if (to - from == 2) {
+        return values[from] * values[from + 1];
+    }
+    size_t middle = from + (to - from) / 2;
+    if (!limbs_prefix.empty() && depth < parallel_options.max_depth &&
+        limbs_prefix[to] - limbs_prefix[from] >= 2 * parallel_options.min_size) {
+        BigInteger low;
+        std::future<void> low_task = fork_task([&] {
+            low = product_tree(values, limbs_prefix, from, middle, depth + 1);
+        });
+        BigInteger high =
+            product_tree(values, limbs_prefix, middle, to, depth + 1);
+        low_task.get();
+        return low * high;
+    }
+    return product_tree(values, limbs_prefix, from, middle, depth + 1) *
+           product_tree(values, limbs_prefix, middle, to, depth + 1);
+}
+
+template <typename Iterator>
+BigInteger BigInteger::product(Iterator first, Iterator last) {
+    std::vector<BigInteger> values;
+    for (; first != last; ++first) {
+        values.emplace_back(*first);
+    }
+    if (values.empty()) {
+        return 1;
+    }
+    std::vector<size_t> limbs_prefix;
+    if (parallel_options.threads > 1) {
+        limbs_prefix.assign(values.size() + 1, 0);
+        for (size_t i = 0; i < values.size(); ++i) {
+            limbs_prefix[i + 1] = limbs_prefix[i] + values[i].digits_.size();
+        }
+    }
+    return product_tree(values, limbs_prefix, 0, values.size(), 0);
+}
+
+template <typename Range>
+BigInteger BigInteger::product(const Range& values) {
+    return product(std::begin(values), std::end(values));
+}
+
+std::vector<unsigned long long> BigInteger::primes_up_to(
+    unsigned long long limit) {
+    std::vector<unsigned long long> primes;
+    std::vector<bool> is_composite(limit + 1);
+    for (unsigned long long i = 2; i <= limit; ++i) {
+        if (is_composite[i]) {
+            continue;
+        }
+        primes.push_back(i);
+        for (unsigned long long j = i * i; j <= limit; j += i) {
+            is_composite[j] = true;
+        }
+    }
+    return primes;
+}
+
+// prod primes[i]^exponents[i] as (...(P_top)^2 * P_(top-1))^2 ... * P_0,
+// where P_bit is the product of the primes whose exponent has that bit set:
+// all the powering is done by squarings of the whole accumulated value.
+// Primes are packed into limb-sized words before the product tree.
+BigInteger BigInteger::prime_power_product(
+    const std::vector<unsigned long long>& primes,
+    const std::vector<unsigned long long>& exponents) {
+    unsigned long long all_bits = 0;
+    for (unsigned long long exponent : exponents) {
+        all_bits |= exponent;
+    }
+    BigInteger result(1);
+    for (int bit = std::bit_width(all_bits); bit-- > 0;) {
+        result *= result;
+        std::vector<long long> words;
+        unsigned long long word = 1;
+        for (size_t i = 0; i < primes.size(); ++i) {
+            if (((exponents[i] >> bit) & 1) == 0) {
+                continue;
+            }
+            if (word > static_cast<unsigned long long>(kBase_ - 1) / primes[i]) {
+                words.push_back(static_cast<long long>(word));
+                word = 1;
+            }
+            word *= primes[i];
+        }
+        words.push_back(static_cast<long long>(word));
+        result *= product(words);
+    }
+    return result;
+}
+
+// n! = prod p^e(p) with Legendre's e(p) = sum n / p^i.
+BigInteger BigInteger::factorial(unsigned long long n) {
+    std::vector<unsigned long long> primes = primes_up_to(n);
+    std::vector<unsigned long long> exponents(primes.size());
+    for (size_t i = 0; i < primes.size(); ++i) {
+        for (unsigned long long rest = n / primes[i]; rest != 0;
+             rest /= primes[i]) {
+            exponents[i] += rest;
+        }
+    }
+    return prime_power_product(primes, exponents);
+}
+
+// The exponent of p in C(n, k) is the number of borrows when subtracting k
+// from n in base p (Kummer), which is at most log_p(n).
+BigInteger BigInteger::binomial(unsigned long long n, unsigned long long k) {
+    if (k > n) {
+        return 0;
+    }
+    k = std::min(k, n - k);
+    std::vector<unsigned long long> primes = primes_up_to(n);
+    std::vector<unsigned long long> exponents(primes.size());
+    for (size_t i = 0; i < primes.size(); ++i) {
+        unsigned long long p = primes[i];
+        unsigned long long top = n, low = k, borrow = 0;
+        while (top != 0) {
+            bool next_borrow = top % p < low % p + borrow;
+            exponents[i] += next_borrow;
+            borrow = next_borrow;
+            top /= p;
+            low /= p;
+        }
+    }
+    return prime_power_product(primes, exponents);
+}
+
+// |this| mod m for 0 < m < 2^31, by Horner's rule over half limbs so that
+// every step is a 64-bit division.
+long long BigInteger::abs_mod_small(long long mod) const {
+    long long remainder = 0;
+    for (size_t i = digits_.size(); i-- > 0;) {
+        remainder = (remainder * kHalfBase_ + digits_[i] / kHalfBase_) % mod;
+        remainder = (remainder * kHalfBase_ + digits_[i] % kHalfBase_) % mod;
+    }
+    return remainder;
+}
+
+// Natural logarithm of a positive value from its two leading limbs.
+long double BigInteger::log_estimate(const BigInteger& number) {
+    size_t n = number.digits_.size();
+    long double top = number.digits_[n - 1];
+    long double scale = n - 1;
+    if (n > 1) {
+        top = top * kBase_ + number.digits_[n - 2];
+        scale = n - 2;
+    }
+    return std::log(top) + scale * kCharsInDigits * std::log(10.0L);
+}
+
+// Positive approximation of the k-th root of a positive value in long
+// double, for roots of at most two limbs.
+BigInteger BigInteger::root_estimate(const BigInteger& number, unsigned k) {
+    long double root = std::exp(log_estimate(number) / k);
+    root = std::ceil(root * (1 + 1e-12L)) + 1;
+    long double high = std::floor(root / kBase_);
+    BigInteger estimate(static_cast<long long>(high));
+    estimate.shift_digits(1);
+    estimate.add_small(static_cast<long long>(
+        std::clamp(root - high * kBase_, 0.0L, kBase_ - 1.0L)));
+    return estimate;
+}
+
+// Newton's iteration x -> ((k - 1) x + n / x^(k - 1)) / k with growing
+// precision: the root of the value without its low k * s limbs is computed
+// first, and shifted by s limbs it is within kBase_^s of the answer, so a
+// couple of full-size steps finish the job. By the AM-GM inequality a step
+// from any positive x lands at or above the floor of the root, from where the
+// iteration decreases until x^k no longer exceeds the value.
+BigInteger BigInteger::newton_root(const BigInteger& number, unsigned k) {
+    size_t shift = number.digits_.size() / (2 * k);
+    BigInteger x;
+    if (shift == 0) {
+        x = root_estimate(number, k);
+    } else {
+        x = newton_root(digits_slice(number, k * shift,
+                                     number.digits_.size()), k);
+        x.add_small(1);
+        x.shift_digits(shift);
+    }
+    auto step = [&number, k](const BigInteger& current) {
+        BigInteger next = number / pow(current, k - 1);
+        next.addmul(current, k - 1);
+        next.divmod_small(k);
+        return next;
+    };
+    x = step(x);
+    while (number < pow(x, k)) {
+        x = step(x);
+    }
+    return x;
+}
+
+BigInteger BigInteger::isqrt(const BigInteger& number) {
+    if (number.is_negative_) {
+        throw std::invalid_argument("isqrt: negative argument");
+    }
+    return iroot(number, 2);
+}
+
+BigInteger BigInteger::iroot(const BigInteger& number, unsigned k) {
+    if (k == 0) {
+        throw std::invalid_argument("iroot: zero degree");
+    }
+    if (number.is_negative_ && k % 2 == 0) {
+        throw std::invalid_argument("iroot: even root of a negative value");
+    }
+    BigInteger magnitude(number);
+    magnitude.is_negative_ = false;
+    if (k == 1 || (magnitude.is_small() && magnitude.digits_[0] <= 1)) {
+        return number;
+    }
+    // number < 2^(60 n), so its root is 1 for every larger k.
+    BigInteger root = k >= 60 * magnitude.digits_.size()
+                          ? BigInteger(1)
+                          : newton_root(magnitude, k);
+    return number.is_negative_ ? -std::move(root) : root;
+}
+
+// Squares modulo 64 * 63 * 65 * 11 rule out all but ~0.35% of non-squares
+// before the root is taken.
+bool BigInteger::is_perfect_square(const BigInteger& number) {
+    const long long kResidueMod = 64 * 63 * 65 * 11;
+    static const std::vector<bool> kIsSquare = [] {
+        std::vector<bool> is_square(kResidueMod);
+        for (long long i = 0; i < kResidueMod; ++i) {
+            is_square[i * i % kResidueMod] = true;
+        }
+        return is_square;
+    }();
+    if (number.is_negative_) {
+        return false;
+    }
+    if (!kIsSquare[number.abs_mod_small(kResidueMod)]) {
+        return false;
+    }
+    BigInteger root = isqrt(number);
+    return root * root == number;
+}
+
+// Only prime exponents need to be tried, and only odd ones for negative
+// values. Most exponents give a root below 2^40: it is rounded from the
+// logarithm and checked modulo 2^31 - 1 first. For the others, k survives if
+// the value is a k-th power residue modulo a few primes q = 1 (mod k), and
+// the root is taken for the survivors.
+bool BigInteger::is_perfect_power(const BigInteger& number) {
+    BigInteger magnitude(number);
+    magnitude.is_negative_ = false;
+    if (magnitude.is_small() && magnitude.digits_[0] <= 1) {
+        return true;
+    }
+    if (!number.is_negative_ && is_perfect_square(number)) {
+        return true;
+    }
+    const int kResidueChecks = 3;
+    const long long kCheckPrime = (1LL << 31) - 1;
+    const long double kSmallRootLog = 40 * std::log(2.0L);
+    long long check_residue = magnitude.abs_mod_small(kCheckPrime);
+    long double log_value = log_estimate(magnitude);
+    for (unsigned long long k :
+         primes_up_to(60 * magnitude.digits_.size())) {
+        if (k == 2) {
+            continue;
+        }
+        if (log_value / k < kSmallRootLog) {
+            long long root = std::llround(std::exp(log_value / k));
+            if (root >= 2 &&
+                pow_mod(root, static_cast<long long>(k), kCheckPrime) ==
+                    check_residue &&
+                pow(BigInteger(root), static_cast<unsigned>(k)) == magnitude) {
+                return true;
+            }
+            continue;
+        }
+        bool is_residue = true;
+        int checks = 0;
+        for (long long q = 2 * k + 1; checks < kResidueChecks && is_residue &&
+                                      q < (1LL << 31);
+             q += 2 * k) {
+            bool q_is_prime = true;
+            for (long long d = 3; d * d <= q && q_is_prime; d += 2) {
+                q_is_prime = q % d != 0;
+            }
+            if (!q_is_prime) {
+                continue;
+            }
+            ++checks;
+            long long residue = magnitude.abs_mod_small(q);
+            is_residue = residue == 0 ||
+                         pow_mod(residue, (q - 1) / static_cast<long long>(k),
+                                 q) == 1;
+        }
+        if (is_residue &&
+            pow(iroot(magnitude, static_cast<unsigned>(k)),
+                static_cast<unsigned>(k)) == magnitude) {
+            return true;
+        }
+    }
+    return false;
+}
+
+class Rational {
+    BigInteger numerator_;
+    BigInteger denominator_ = 1;
+    // False while lazy normalization has left a common factor in place; the
+    // denominator is kept positive either way.
+    bool is_reduced_ = true;
+
+    void to_prime_form() {
+        bool is_neg = (numerator_.sign() * denominator_.sign() == -1);
+
+        if (numerator_.sign() == -1) {
+            numerator_ *= -1;
+        }
+
+        if (denominator_.sign() == -1) {
+            denominator_ *= -1;
+        }
+
+        BigInteger gcd_ = BigInteger::gcd(numerator_, denominator_);
+        if (gcd_ != 1) {
+            numerator_ /= gcd_;
+            denominator_ /= gcd_;
+        }
+        if (is_neg) numerator_ *= -1;
+        is_reduced_ = true;
+    }
+
+    void add(const Rational&, bool);
+    void multiply(const BigInteger&, const BigInteger&, bool);
+    void reduce_if_large();
+    Rational reduced() const;
+
+  public:
+    // Opt-in deferred normalization. With lazy set, + - * / skip the gcd and
+    // a value is reduced only once its numerator and denominator together
+    // exceed max_limbs, or on normalize(). Comparison and output give the
+    // same results either way.
+    struct NormalizationOptions {
+        bool lazy = false;
+        size_t max_limbs = 64;
+    };
+    static NormalizationOptions normalization;
+
+    Rational() = default;
+
+    Rational(const BigInteger& numerator, const BigInteger& denominator)
+        : numerator_(numerator), denominator_(denominator) {
+        to_prime_form();
+    }
+
+    Rational(const BigInteger& x) : numerator_(x), denominator_(1) {
+        to_prime_form();
+    }
+
+    Rational(long long x) : numerator_(x), denominator_(1) {}
+
+    Rational& operator+=(const Rational&);
+    Rational& operator-=(const Rational&);
+    Rational& operator*=(const Rational&);
+    Rational& operator/=(const Rational&);
+    Rational operator-() const&;
+    Rational operator-() &&;
+    // Reduces to lowest terms.
+    void normalize();
+    friend std::strong_ordering operator<=>(const Rational&, const Rational&);
+    friend bool operator==(const Rational&, const Rational&);
+    friend std::istream& operator>>(std::istream&, Rational&);
+    // Parses "p" or "p/q" at the start of [first, last) like
+    // BigInteger::from_chars and returns the end of the number. Throws
+    // std::invalid_argument if q is zero.
+    static const char* from_chars(const char*, const char*, Rational&);
+    // Binary format: the numerator and then the positive denominator, each
+    // laid out as in BigInteger::to_binary. Values are written in lowest
+    // terms; loaded values are reduced, since the data may not be.
+    size_t binary_size() const;
+    char* to_binary(char*) const;
+    static const char* from_binary(const char*, const char*, Rational&);
+    void write_binary(std::ostream&) const;
+    static void read_binary(std::istream&, Rational&);
+    static void write_binary(std::ostream&, const std::vector<Rational>&);
+    static void read_binary(std::istream&, std::vector<Rational>&);
+    static const char* read_binary(const char*, const char*,
+                                   std::vector<Rational>&);
+    friend class BigFloat;
+    std::string toString() const;
+    std::string asDecimal(size_t);
+    // Correctly rounded (to nearest, ties to even), including subnormal
+    // results and overflow to infinity.
+    explicit operator double() const;
+};
+
+Rational::NormalizationOptions Rational::normalization;
+
+// Reads "p" or "p/q"; a zero q sets failbit.
+std::istream& operator>>(std::istream& input, Rational& number) {
+    if (!(input >> number.numerator_)) {
+        return input;
+    }
+    number.denominator_ = 1;
+    if (input.rdbuf()->sgetc() == '/') {
+        input.rdbuf()->sbumpc();
+        if (!(input >> number.denominator_) ||
+            number.denominator_.sign() == 0) {
+            input.setstate(std::ios_base::failbit);
+            number.denominator_ = 1;
+        }
+    }
+    number.to_prime_form();
+    return input;
+}
+
+const char* Rational::from_chars(const char* first, const char* last,
+                                 Rational& value) {
+    first = BigInteger::from_chars(first, last, value.numerator_);
+    if (first != last && *first == '/') {
+        first = BigInteger::from_chars(first + 1, last, value.denominator_);
+        if (value.denominator_.is_zero()) {
+            value.denominator_ = 1;
+            value.is_reduced_ = true;
+            throw std::invalid_argument("Rational: zero denominator");
+        }
+    } else {
+        value.denominator_ = 1;
+    }
+    value.to_prime_form();
+    return first;
+}
+
+size_t Rational::binary_size() const {
+    if (!is_reduced_) {
+        return reduced().binary_size();
+    }
+    return numerator_.binary_size() + denominator_.binary_size();
+}
+
+char* Rational::to_binary(char* out) const {
+    if (!is_reduced_) {
+        return reduced().to_binary(out);
+    }
+    return denominator_.to_binary(numerator_.to_binary(out));
+}
+
+const char* Rational::from_binary(const char* first, const char* last,
+                                  Rational& value) {
+    BigInteger numerator;
+    BigInteger denominator;
+    first = BigInteger::from_binary(first, last, numerator);
+    first = BigInteger::from_binary(first, last, denominator);
+    if (denominator.sign() != 1) {
+        throw std::invalid_argument("Rational: malformed binary denominator");
+    }
+    value.numerator_ = std::move(numerator);
+    value.denominator_ = std::move(denominator);
+    value.to_prime_form();
+    return first;
+}
+
+void Rational::write_binary(std::ostream& output) const {
+    if (!is_reduced_) {
+        reduced().write_binary(output);
+        return;
+    }
+    numerator_.write_binary(output);
+    denominator_.write_binary(output);
+}
+
+void Rational::read_binary(std::istream& input, Rational& value) {
+    BigInteger numerator;
+    BigInteger denominator;
+    BigInteger::read_binary(input, numerator);
+    BigInteger::read_binary(input, denominator);
+    if (denominator.sign() != 1) {
+        throw std::invalid_argument("Rational: malformed binary denominator");
+    }
+    value.numerator_ = std::move(numerator);
+    value.denominator_ = std::move(denominator);
+    value.to_prime_form();
+}
+
+void Rational::write_binary(std::ostream& output,
+                            const std::vector<Rational>& values) {
+    BigInteger::write_array(output, values, BigInteger::kBinaryRationalKind_);
+}
+
+void Rational::read_binary(std::istream& input,
+                           std::vector<Rational>& values) {
+    BigInteger::read_array(input, values, BigInteger::kBinaryRationalKind_);
+}
+
+const char* Rational::read_binary(const char* first, const char* last,
+                                  std::vector<Rational>& values) {
+    return BigInteger::read_array(first, last, values,
+                                  BigInteger::kBinaryRationalKind_);
+}
+
+Rational operator+(const Rational& lhs, const Rational& rhs) {
+    Rational ans(lhs);
+    ans += rhs;
+    return ans;
+}
+
+Rational operator+(Rational&& lhs, const Rational& rhs) {
+    lhs += rhs;
+    return std::move(lhs);
+}
+
+Rational operator+(const Rational& lhs, Rational&& rhs) {
+    rhs += lhs;
+    return std::move(rhs);
+}
+
+Rational operator+(Rational&& lhs, Rational&& rhs) {
+    lhs += rhs;
+    return std::move(lhs);
+}
+
+Rational operator-(const Rational& lhs, const Rational& rhs) {
+    Rational ans(lhs);
+    ans -= rhs;
+    return ans;
+}
+
+Rational operator-(Rational&& lhs, const Rational& rhs) {
+    lhs -= rhs;
+    return std::move(lhs);
+}
+
+Rational operator*(const Rational& lhs, const Rational& rhs) {
+    Rational ans(lhs);
+    ans *= rhs;
+    return ans;
+}
+
+Rational operator*(Rational&& lhs, const Rational& rhs) {
+    lhs *= rhs;
+    return std::move(lhs);
+}
+
+Rational operator*(const Rational& lhs, Rational&& rhs) {
+    rhs *= lhs;
+    return std::move(rhs);
+}
+
+Rational operator*(Rational&& lhs, Rational&& rhs) {
+    lhs *= rhs;
+    return std::move(lhs);
+}
+
+Rational operator/(const Rational& lhs, const Rational& rhs) {
+    Rational ans(lhs);
+    ans /= rhs;
+    return ans;
+}
+
+Rational operator/(Rational&& lhs, const Rational& rhs) {
+    lhs /= rhs;
+    return std::move(lhs);
+}
+
+void Rational::normalize() {
+    if (!is_reduced_) {
+        to_prime_form();
+    }
+}
+
+Rational Rational::reduced() const {
+    Rational result(*this);
+    result.normalize();
+    return result;
+}
+
+void Rational::reduce_if_large() {
+    if (numerator_.digits_.size() + denominator_.digits_.size() >
+        normalization.max_limbs) {
+        to_prime_form();
+    }
+}
+
+// Henrici's formulas for reduced a/b and c/d: with g = gcd(b, d) the sum is
+// t / (b/g * d) for t = a*(d/g) + c*(b/g), and only gcd(t, g) can still be
+// common. Both gcds run on operands the size of the inputs, not of the
+// cross products.
+void Rational::add(const Rational& rhs, bool subtract) {
+    BigInteger cross = rhs.numerator_;
+    if (subtract) {
+        cross = -std::move(cross);
+    }
+    if (normalization.lazy || !is_reduced_ || !rhs.is_reduced_) {
+        numerator_ *= rhs.denominator_;
+        numerator_ += cross * denominator_;
+        denominator_ *= rhs.denominator_;
+        is_reduced_ = false;
+        if (normalization.lazy) {
+            reduce_if_large();
+        } else {
+            to_prime_form();
+        }
+        return;
+    }
+
+    BigInteger g = BigInteger::gcd(denominator_, rhs.denominator_);
+    if (g == 1) {
+        numerator_ *= rhs.denominator_;
+        numerator_ += cross * denominator_;
+        denominator_ *= rhs.denominator_;
+        return;
+    }
+    BigInteger lhs_part = denominator_ / g;
+    BigInteger rhs_part = rhs.denominator_ / g;
+    numerator_ *= rhs_part;
+    numerator_ += cross * lhs_part;
+    if (numerator_.is_zero()) {
+        denominator_ = 1;
+        return;
+    }
+    BigInteger common = BigInteger::gcd(numerator_, g);
+    if (common != 1) {
+        numerator_ /= common;
+        rhs_part = rhs.denominator_ / common;
+    } else {
+        rhs_part = rhs.denominator_;
+    }
+    denominator_ = std::move(lhs_part) * rhs_part;
+}
+
+// Multiplies by c/d with d > 0. For reduced operands gcd(a, d) and gcd(c, b)
+// are the only common factors, and they are cancelled before multiplying.
+void Rational::multiply(const BigInteger& rhs_numerator,
+                        const BigInteger& rhs_denominator, bool rhs_reduced) {
+    if (normalization.lazy || !is_reduced_ || !rhs_reduced) {
+        numerator_ *= rhs_numerator;
+        denominator_ *= rhs_denominator;
+        is_reduced_ = false;
+        if (normalization.lazy) {
+            reduce_if_large();
+        } else {
+            to_prime_form();
+        }
+        return;
+    }
+    if (numerator_.is_zero() || rhs_numerator.is_zero()) {
+        numerator_ = 0;
+        denominator_ = 1;
+        return;
+    }
+    BigInteger lhs_common = BigInteger::gcd(numerator_, rhs_denominator);
+    BigInteger rhs_common = BigInteger::gcd(rhs_numerator, denominator_);
+    if (lhs_common != 1) {
+        numerator_ /= lhs_common;
+    }
+    if (rhs_common != 1) {
+        denominator_ /= rhs_common;
+        numerator_ *= rhs_numerator / rhs_common;
+    } else {
+        numerator_ *= rhs_numerator;
+    }
+    if (lhs_common != 1) {
+        denominator_ *= rhs_denominator / lhs_common;
+    } else {
+        denominator_ *= rhs_denominator;
+    }
+}
+
+Rational& Rational::operator+=(const Rational& rhs) {
+    add(rhs, false);
+    return *this;
+}
+
+Rational& Rational::operator-=(const Rational& rhs) {
+    add(rhs, true);
+    return *this;
+}
+
+Rational& Rational::operator*=(const Rational& rhs) {
+    if (this == &rhs) {
+        Rational copy(rhs);
+        multiply(copy.numerator_, copy.denominator_, copy.is_reduced_);
+    } else {
+        multiply(rhs.numerator_, rhs.denominator_, rhs.is_reduced_);
+    }
+    return *this;
+}
+
+// Multiplies by the reciprocal, moving its sign to the numerator.
+Rational& Rational::operator/=(const Rational& rhs) {
+    if (rhs.numerator_.is_zero()) {
+        throw std::invalid_argument("Rational: division by zero");
+    }
+    BigInteger rhs_numerator = rhs.denominator_;
+    BigInteger rhs_denominator = rhs.numerator_;
+    if (rhs_denominator.is_negative_) {
+        rhs_numerator = -std::move(rhs_numerator);
+        rhs_denominator = -std::move(rhs_denominator);
+    }
+    multiply(rhs_numerator, rhs_denominator, rhs.is_reduced_);
+    return *this;
+}
+
+Rational Rational::operator-() const& {
+    Rational result(*this);
+    return -std::move(result);
+}
+
+Rational Rational::operator-() && {
+    numerator_ = -std::move(numerator_);
+    return std::move(*this);
+}
+
+std::strong_ordering operator<=>(const Rational& lhs, const Rational& rhs) {
+    BigInteger left(lhs.numerator_ * rhs.denominator_);
+    BigInteger right(lhs.denominator_ * rhs.numerator_);
+    return left <=> right;
+}
+
+// Reduced values are equal only if their parts are; otherwise the cross
+// products decide.
+bool operator==(const Rational& lhs, const Rational& rhs) {
+    if (lhs.is_reduced_ && rhs.is_reduced_) {
+        return lhs.numerator_ == rhs.numerator_ &&
+               lhs.denominator_ == rhs.denominator_;
+    }
+    return lhs.numerator_ * rhs.denominator_ ==
+           lhs.denominator_ * rhs.numerator_;
+}
+
+std::string Rational::toString() const {
+    Rational ans_rational = *this;
+    ans_rational.to_prime_form();
+    std::string ans = ans_rational.numerator_.toString();
+    if (ans_rational.denominator_ == BigInteger(1)) return ans;
+    ans += "/" + ans_rational.denominator_.toString();
+    return ans;
+}
+
+// The magnitude is scaled by 10^precision (whole limbs by a shift, the rest
+// by one mul_small) and divided once; the point is placed in the quotient.
+std::string Rational::asDecimal(size_t precision = 0) {
+    if (precision == 0) {
+        return (numerator_ / denominator_).toString();
+    }
+    BigInteger precise_number(numerator_);
+    precise_number.is_negative_ = false;
+    precise_number.shift_digits(precision / BigInteger::kCharsInDigits);
+    long long scale = 1;
+    for (size_t i = 0; i < precision % BigInteger::kCharsInDigits; ++i) {
+        scale *= 10;
+    }
+    precise_number.mul_small(scale);
+    precise_number /= denominator_;
+
+    std::string digits = precise_number.toString();
+    if (digits.size() <= precision) {
+        digits.insert(0, precision + 1 - digits.size(), '0');
+    }
+    std::string result;
+    if (numerator_.is_negative_) {
+        result.push_back('-');
+    }
+    result.append(digits, 0, digits.size() - precision);
+    result.push_back('.');
+    result.append(digits, digits.size() - precision, precision);
+    return result;
+}
+
+// Small parts are divided in hardware, which IEEE rounds correctly.
+// Otherwise the numerator or the denominator is scaled by a power of two so
+// that q = floor(n * 2^s / d) has 60 to 72 bits, one 128-bit division for
+// single limbs and one BigInteger::divmod beyond, and q is rounded to the
+// precision of the result with the remainder as the sticky bit.
+Rational::operator double() const {
+    const long long kExactLimit = 1LL << 53;
+    const double kLimbBits = 59.794705707972522;  // log2(kBase_)
+    if (numerator_.is_zero()) {
+        return 0.0;
+    }
+    double sign = numerator_.is_negative_ ? -1.0 : 1.0;
+
+    unsigned __int128 q;
+    bool sticky;
+    long long shift;
+    if (numerator_.is_small() && denominator_.is_small()) {
+        unsigned long long n = numerator_.digits_[0];
+        unsigned long long d = denominator_.digits_[0];
+        if (n <= kExactLimit && d <= kExactLimit) {
+            return sign * static_cast<double>(n) / static_cast<double>(d);
+        }
+        shift = 61 + std::bit_width(d) - std::bit_width(n);
+        unsigned __int128 scaled = static_cast<unsigned __int128>(n) << shift;
+        q = scaled / d;
+        sticky = scaled % d != 0;
+    } else {
+        auto bit_length = [&](const BigInteger& number) {
+            return (number.digits_.size() - 1) * kLimbBits +
+                   std::bit_width(
+                       static_cast<unsigned long long>(number.digits_.back()));
+        };
+        long long bits_difference =
+            std::llround(bit_length(numerator_) - bit_length(denominator_));
+        if (bits_difference > 1100) {
+            return sign * std::numeric_limits<double>::infinity();
+        }
+        if (bits_difference < -1100) {
+            return sign * 0.0;
+        }
+
+        BigInteger scaled_numerator(numerator_);
+        scaled_numerator.is_negative_ = false;
+        BigInteger scaled_denominator(denominator_);
+        shift = 66 - bits_difference;
+        BigInteger& scaled =
+            shift >= 0 ? scaled_numerator : scaled_denominator;
+        for (long long left = std::abs(shift); left > 0; left -= 62) {
+            scaled.mul_small(1LL << std::min<long long>(left, 62));
+        }
+        auto [quotient, remainder] =
+            BigInteger::divmod(scaled_numerator, scaled_denominator);
+        q = static_cast<unsigned long long>(quotient.digits_[0]);
+        if (quotient.digits_.size() > 1) {
+            q += static_cast<unsigned __int128>(quotient.digits_[1]) *
+                 BigInteger::kBase_;
+        }
+        sticky = !remainder.is_zero();
+    }
+
+    unsigned long long high = static_cast<unsigned long long>(q >> 64);
+    int length = high ? 128 - std::countl_zero(high)
+                      : 64 - std::countl_zero(static_cast<unsigned long long>(q));
+    // The value lies in [2^exponent, 2^(exponent + 1)).
+    long long exponent = length - 1 - shift;
+    long long kept = 53;
+    if (exponent < -1022) {
+        kept -= -1022 - exponent;
+    }
+    if (kept < 0) {
+        return sign * 0.0;
+    }
+    int dropped = length - static_cast<int>(kept);
+    unsigned long long mantissa = static_cast<unsigned long long>(q >> dropped);
+    unsigned __int128 rest = q & ((static_cast<unsigned __int128>(1)
+                                   << dropped) - 1);
+    unsigned __int128 half = static_cast<unsigned __int128>(1) << (dropped - 1);
+    if (rest > half || (rest == half && (sticky || (mantissa & 1)))) {
+        ++mantissa;
+    }
+    return sign * std::ldexp(static_cast<double>(mantissa),
+                             static_cast<int>(dropped - shift));
+}
+// Signed Bits-wide integer in two's complement over 64-bit limbs: no sign or
+// size bookkeeping, arithmetic wraps modulo 2^Bits like the built-in types.
+// Carry chains are unrolled over the compile-time limb count and everything
+// except the conversions to and from text and BigInteger is constexpr.
+template <size_t Bits>
+class FixedBigInt {
+    static_assert(Bits > 0 && Bits % 64 == 0,
+                  "FixedBigInt: Bits must be a positive multiple of 64");
+
+    static constexpr size_t kLimbs_ = Bits / 64;
+    using Limbs = std::array<unsigned long long, kLimbs_>;
+    using Indices = std::make_index_sequence<kLimbs_>;
+
+    Limbs limbs_{};
+
+    static constexpr unsigned long long add_carry(unsigned long long lhs,
+                                                  unsigned long long rhs,
+                                                  unsigned long long& carry) {
+        unsigned __int128 sum =
+            static_cast<unsigned __int128>(lhs) + rhs + carry;
+        carry = static_cast<unsigned long long>(sum >> 64);
+        return static_cast<unsigned long long>(sum);
+    }
+
+    static constexpr unsigned long long sub_borrow(unsigned long long lhs,
+                                                   unsigned long long rhs,
+                                                   unsigned long long& borrow) {
+        unsigned __int128 difference =
+            static_cast<unsigned __int128>(lhs) - rhs - borrow;
+        borrow = static_cast<unsigned long long>(difference >> 64) & 1;
+        return static_cast<unsigned long long>(difference);
+    }
+
+    template <size_t... Idx>
+    constexpr void add_limbs(const Limbs& rhs, std::index_sequence<Idx...>) {
+        unsigned long long carry = 0;
+        ((limbs_[Idx] = add_carry(limbs_[Idx], rhs[Idx], carry)), ...);
+    }
+
+    template <size_t... Idx>
+    constexpr void sub_limbs(const Limbs& rhs, std::index_sequence<Idx...>) {
+        unsigned long long borrow = 0;
+        ((limbs_[Idx] = sub_borrow(limbs_[Idx], rhs[Idx], borrow)), ...);
+    }
+
+    static constexpr unsigned long long mul_add(unsigned long long lhs,
+                                                unsigned long long rhs,
+                                                unsigned long long addend,
+                                                unsigned long long& carry) {
+        unsigned __int128 current =
+            static_cast<unsigned __int128>(lhs) * rhs + addend + carry;
+        carry = static_cast<unsigned long long>(current >> 64);
+        return static_cast<unsigned long long>(current);
+    }
+
+    // Adds limbs_[Row] * rhs to product from limb Row on; the carry out of
+    // the top limb is dropped.
+    template <size_t Row, size_t... Idx>
+    constexpr void mul_row(const Limbs& rhs, Limbs& product,
+                           std::index_sequence<Idx...>) const {
+        unsigned long long carry = 0;
+        ((product[Row + Idx] =
+              mul_add(limbs_[Row], rhs[Idx], product[Row + Idx], carry)),
+         ...);
+    }
+
+    template <size_t... Row>
+    constexpr Limbs mul_limbs(const Limbs& rhs,
+                              std::index_sequence<Row...>) const {
+        Limbs product{};
+        (mul_row<Row>(rhs, product, std::make_index_sequence<kLimbs_ - Row>()),
+         ...);
+        return product;
+    }
+
+    constexpr void mul_small(unsigned long long factor,
+                             unsigned long long addend) {
+        unsigned long long carry = addend;
+        for (size_t i = 0; i < kLimbs_; ++i) {
+            unsigned __int128 product =
+                static_cast<unsigned __int128>(limbs_[i]) * factor + carry;
+            limbs_[i] = static_cast<unsigned long long>(product);
+            carry = static_cast<unsigned long long>(product >> 64);
+        }
+    }
+
+    constexpr FixedBigInt magnitude() const {
+        return is_negative() ? -*this : *this;
+    }
+
+    // Knuth's Algorithm D on the unsigned limbs (Hacker's Delight divmnu).
+    static constexpr void divmod_unsigned(const Limbs& u, const Limbs& v,
+                                          Limbs& quotient, Limbs& remainder) {
+        quotient = Limbs{};
+        remainder = Limbs{};
+        size_t n = kLimbs_;
+        while (n > 0 && v[n - 1] == 0) {
+            --n;
+        }
+        if (n == 0) {
+            throw std::invalid_argument("FixedBigInt: division by zero");
+        }
+        size_t m = kLimbs_;
+        while (m > 0 && u[m - 1] == 0) {
+            --m;
+        }
+        if (m < n) {
+            remainder = u;
+            return;
+        }
+        if (n == 1) {
+            unsigned long long rest = 0;
+            for (size_t i = m; i-- > 0;) {
+                unsigned __int128 current =
+                    (static_cast<unsigned __int128>(rest) << 64) | u[i];
+                quotient[i] = static_cast<unsigned long long>(current / v[0]);
+                rest = static_cast<unsigned long long>(current % v[0]);
+            }
+            remainder[0] = rest;
+            return;
+        }
+
+        int shift = std::countl_zero(v[n - 1]);
+        std::array<unsigned long long, kLimbs_ + 1> un{};
+        Limbs vn{};
+        for (size_t i = n; i-- > 1;) {
+            vn[i] = shift ? (v[i] << shift) | (v[i - 1] >> (64 - shift)) : v[i];
+        }
+        vn[0] = v[0] << shift;
+        un[m] = shift ? u[m - 1] >> (64 - shift) : 0;
+        for (size_t i = m; i-- > 1;) {
+            un[i] = shift ? (u[i] << shift) | (u[i - 1] >> (64 - shift)) : u[i];
+        }
+        un[0] = u[0] << shift;
+
+        for (size_t j = m - n + 1; j-- > 0;) {
+            unsigned __int128 numerator =
+                (static_cast<unsigned __int128>(un[j + n]) << 64) | un[j + n - 1];
+            unsigned __int128 q_hat = numerator / vn[n - 1];
+            unsigned __int128 r_hat = numerator % vn[n - 1];
+            while (q_hat >> 64 ||
+                   q_hat * vn[n - 2] > ((r_hat << 64) | un[j + n - 2])) {
+                --q_hat;
+                r_hat += vn[n - 1];
+                if (r_hat >> 64) {
+                    break;
+                }
+            }
+
+            unsigned long long carry = 0;
+            unsigned long long borrow = 0;
+            for (size_t i = 0; i < n; ++i) {
+                unsigned __int128 product = q_hat * vn[i] + carry;
+                carry = static_cast<unsigned long long>(product >> 64);
+                un[i + j] = sub_borrow(
+                    un[i + j], static_cast<unsigned long long>(product), borrow);
+            }
+            un[j + n] = sub_borrow(un[j + n], carry, borrow);
+
+            if (borrow) {
+                --q_hat;
+                carry = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    un[i + j] = add_carry(un[i + j], vn[i], carry);
+                }
+                un[j + n] += carry;
+            }
+            quotient[j] = static_cast<unsigned long long>(q_hat);
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            remainder[i] = shift ? (un[i] >> shift) | (un[i + 1] << (64 - shift))
+                                 : un[i];
+        }
+    }
+
+    // Truncating signed division, the remainder takes the sign of the
+    // dividend.
+    static constexpr void divmod(const FixedBigInt& lhs, const FixedBigInt& rhs,
+                                 FixedBigInt& quotient, FixedBigInt& remainder) {
+        bool lhs_is_neg = lhs.is_negative();
+        bool rhs_is_neg = rhs.is_negative();
+        divmod_unsigned(lhs.magnitude().limbs_, rhs.magnitude().limbs_,
+                        quotient.limbs_, remainder.limbs_);
+        if (lhs_is_neg != rhs_is_neg) {
+            quotient = -quotient;
+        }
+        if (lhs_is_neg) {
+            remainder = -remainder;
+        }
+    }
+
+  public:
+    constexpr FixedBigInt() = default;
+
+    constexpr FixedBigInt(long long value) {
+        limbs_[0] = static_cast<unsigned long long>(value);
+        for (size_t i = 1; i < kLimbs_; ++i) {
+            limbs_[i] = value < 0 ? ~0ull : 0;
+        }
+    }
+
+    // Reduced modulo 2^Bits.
+    explicit FixedBigInt(const BigInteger& number) {
+        for (size_t i = number.digits_.size(); i-- > 0;) {
+            mul_small(BigInteger::kBase_,
+                      static_cast<unsigned long long>(number.digits_[i]));
+        }
+        if (number.is_negative_) {
+            *this = -*this;
+        }
+    }
+
+    explicit operator BigInteger() const {
+        FixedBigInt abs_value = magnitude();
+        BigInteger result(0);
+        for (size_t i = kLimbs_; i-- > 0;) {
+            result.mul_small(1LL << 32);
+            result.add_small(static_cast<long long>(abs_value.limbs_[i] >> 32));
+            result.mul_small(1LL << 32);
+            result.add_small(
+                static_cast<long long>(abs_value.limbs_[i] & 0xffffffffull));
+        }
+        return is_negative() ? -std::move(result) : result;
+    }
+
+    constexpr bool is_negative() const {
+        return limbs_[kLimbs_ - 1] >> 63;
+    }
+
+    constexpr explicit operator bool() const {
+        return *this != FixedBigInt();
+    }
+
+    constexpr FixedBigInt operator-() const {
+        FixedBigInt result;
+        result.sub_limbs(limbs_, Indices{});
+        return result;
+    }
+
+    constexpr FixedBigInt& operator+=(const FixedBigInt& rhs) {
+        add_limbs(rhs.limbs_, Indices{});
+        return *this;
+    }
+
+    constexpr FixedBigInt& operator-=(const FixedBigInt& rhs) {
+        sub_limbs(rhs.limbs_, Indices{});
+        return *this;
+    }
+
+    // Only the low kLimbs_ limbs of the product are computed.
+    constexpr FixedBigInt& operator*=(const FixedBigInt& rhs) {
+        limbs_ = mul_limbs(rhs.limbs_, Indices{});
+        return *this;
+    }
+
+    constexpr FixedBigInt& operator/=(const FixedBigInt& rhs) {
+        FixedBigInt remainder;
+        divmod(*this, rhs, *this, remainder);
+        return *this;
+    }
+
+    constexpr FixedBigInt& operator%=(const FixedBigInt& rhs) {
+        FixedBigInt quotient;
+        divmod(*this, rhs, quotient, *this);
+        return *this;
+    }
+
+    constexpr FixedBigInt& operator++() {
+        return *this += 1;
+    }
+
+    constexpr FixedBigInt& operator--() {
+        return *this -= 1;
+    }
+
+    constexpr FixedBigInt operator++(int) {
+        FixedBigInt old(*this);
+        ++*this;
+        return old;
+    }
+
+    constexpr FixedBigInt operator--(int) {
+        FixedBigInt old(*this);
+        --*this;
+        return old;
+    }
+
+    constexpr bool operator==(const FixedBigInt&) const = default;
+
+    friend constexpr std::strong_ordering operator<=>(const FixedBigInt& lhs,
+                                                      const FixedBigInt& rhs) {
+        if (lhs.is_negative() != rhs.is_negative()) {
+            return lhs.is_negative() ? std::strong_ordering::less
+                                     : std::strong_ordering::greater;
+        }
+        for (size_t i = kLimbs_; i-- > 0;) {
+            if (lhs.limbs_[i] != rhs.limbs_[i]) {
+                return lhs.limbs_[i] < rhs.limbs_[i]
+                           ? std::strong_ordering::less
+                           : std::strong_ordering::greater;
+            }
+        }
+        return std::strong_ordering::equal;
+    }
+
+    // Hidden friends, so that mixed operations with integers convert.
+    friend constexpr FixedBigInt operator+(FixedBigInt lhs,
+                                           const FixedBigInt& rhs) {
+        return lhs += rhs;
+    }
+
+    friend constexpr FixedBigInt operator-(FixedBigInt lhs,
+                                           const FixedBigInt& rhs) {
+        return lhs -= rhs;
+    }
+
+    friend constexpr FixedBigInt operator*(FixedBigInt lhs,
+                                           const FixedBigInt& rhs) {
+        return lhs *= rhs;
+    }
+
+    friend constexpr FixedBigInt operator/(FixedBigInt lhs,
+                                           const FixedBigInt& rhs) {
+        return lhs /= rhs;
+    }
+
+    friend constexpr FixedBigInt operator%(FixedBigInt lhs,
+                                           const FixedBigInt& rhs) {
+        return lhs %= rhs;
+    }
+
+    std::string toString() const {
+        return static_cast<BigInteger>(*this).toString();
+    }
+};
+
+template <size_t Bits>
+std::istream& operator>>(std::istream& input, FixedBigInt<Bits>& number) {
+    BigInteger value;
+    input >> value;
+    number = FixedBigInt<Bits>(value);
+    return input;
+}
+
+template <size_t Bits>
+std::ostream& operator<<(std::ostream& output, const FixedBigInt<Bits>& number) {
+    output << number.toString();
+    return output;
+}
+
+// Decimal floating point value mantissa * 10^exponent. Every operation rounds
+// its exact result to precision_options.precision significant digits in the
+// chosen mode, so results do not depend on the precision of the operands.
+// The mantissa is kept without trailing zeros, which makes the
+// representation unique.
+class BigFloat {
+  public:
+    enum class RoundingMode {
+        kNearestEven,
+        kTowardZero,
+        kDown,
+        kUp,
+        kAwayFromZero,
+    };
+
+    struct PrecisionOptions {
+        size_t precision = 50;
+        RoundingMode rounding = RoundingMode::kNearestEven;
+    };
+    static PrecisionOptions precision_options;
+
+  private:
+    BigInteger mantissa_;
+    long long exponent_ = 0;
+
+    static constexpr long long power_of_ten(long long power) {
+        long long result = 1;
+        for (long long i = 0; i < power; ++i) {
+            result *= 10;
+        }
+        return result;
+    }
+
+    static long long digit_count(const BigInteger&);
+    static void scale(BigInteger&, long long);
+    int sign() const;
+    void strip_zeros();
+    void round_off(long long, bool);
+    void round_to_precision(bool);
+    void add(const BigFloat&, bool);
+    void divide(BigInteger, const BigInteger&);
+
+  public:
+    BigFloat() = default;
+
+    BigFloat(long long x) : mantissa_(x) {
+        round_to_precision(false);
+    }
+
+    BigFloat(const BigInteger& x) : mantissa_(x) {
+        round_to_precision(false);
+    }
+
+    // One division of the numerator scaled to precision + 1 digits.
+    explicit BigFloat(const Rational&);
+    // Parses "[-]digits[.digits][e[+-]digits]", throws std::invalid_argument
+    // on anything else and std::out_of_range if the exponent is beyond half
+    // the range of long long.
+    explicit BigFloat(const std::string&);
+
+    // Exact: the denominator is a power of ten.
+    explicit operator Rational() const;
+
+    BigFloat& operator+=(const BigFloat&);
+    BigFloat& operator-=(const BigFloat&);
+    BigFloat& operator*=(const BigFloat&);
+    BigFloat& operator/=(const BigFloat&);
+    BigFloat operator-() const&;
+    BigFloat operator-() &&;
+
+    // Correctly rounded square root of a nonnegative value.
+    static BigFloat sqrt(const BigFloat&);
+
+    friend std::strong_ordering operator<=>(const BigFloat&, const BigFloat&);
+    friend bool operator==(const BigFloat&, const BigFloat&) = default;
+
+    // Hidden friends, so that mixed operations with integers convert.
+    friend BigFloat operator+(BigFloat lhs, const BigFloat& rhs) {
+        return lhs += rhs;
+    }
+
+    friend BigFloat operator-(BigFloat lhs, const BigFloat& rhs) {
+        return lhs -= rhs;
+    }
+
+    friend BigFloat operator*(BigFloat lhs, const BigFloat& rhs) {
+        return lhs *= rhs;
+    }
+
+    friend BigFloat operator/(BigFloat lhs, const BigFloat& rhs) {
+        return lhs /= rhs;
+    }
+
+    // Shortest digits of the value, in positional notation for magnitudes in
+    // [1e-7, 1e21) and in scientific notation ("1.5e+30") otherwise.
+    std::string toString() const;
+    // Positional notation with exactly precision digits after the point,
+    // rounded in precision_options.rounding mode.
+    std::string asDecimal(size_t) const;
+};
+
+BigFloat::PrecisionOptions BigFloat::precision_options;
+
+long long BigFloat::digit_count(const BigInteger& number) {
+    long long count =
+        static_cast<long long>(number.digits_.size() - 1) *
+        BigInteger::kCharsInDigits;
+    for (long long top = number.digits_.back(); top != 0; top /= 10) {
+        ++count;
+    }
+    return count;
+}
+
+// Multiplies by 10^power: whole limbs by a shift, the rest by one mul_small.
+void BigFloat::scale(BigInteger& number, long long power) {
+    number.shift_digits(
+        static_cast<size_t>(power / BigInteger::kCharsInDigits));
+    number.mul_small(power_of_ten(power % BigInteger::kCharsInDigits));
+}
+
+int BigFloat::sign() const {
+    if (mantissa_.is_zero()) {
+        return 0;
+    }
+    return mantissa_.is_negative_ ? -1 : 1;
+}
+
+// Zero limbs are dropped whole, the zeros of the lowest nonzero limb by one
+// divmod_small.
+void BigFloat::strip_zeros() {
+    if (mantissa_.is_zero()) {
+        exponent_ = 0;
+        return;
+    }
+    size_t zero_limbs = 0;
+    while (mantissa_.digits_[zero_limbs] == 0) {
+        ++zero_limbs;
+    }
+    if (zero_limbs > 0) {
+        bool is_negative = mantissa_.is_negative_;
+        mantissa_ = BigInteger::digits_slice(mantissa_, zero_limbs,
+                                             mantissa_.digits_.size());
+        mantissa_.is_negative_ = is_negative;
+        exponent_ += static_cast<long long>(zero_limbs) *
+                     BigInteger::kCharsInDigits;
+    }
+    long long zeros = 0;
+    for (long long low = mantissa_.digits_[0]; low % 10 == 0; low /= 10) {
+        ++zeros;
+    }
+    if (zeros > 0) {
+        mantissa_.divmod_small(power_of_ten(zeros));
+        exponent_ += zeros;
+    }
+}
+
+// Drops the low count digits of the mantissa. Whether the dropped part is
+// below, at or above half a unit of the last kept digit is decided by its
+// leading limb or partial limb, with sticky and the lower limbs as a tie
+// breaker; no division by a big power of ten is needed.
+void BigFloat::round_off(long long count, bool sticky) {
+    if (count <= 0) {
+        strip_zeros();
+        return;
+    }
+    bool is_negative = mantissa_.is_negative_;
+    mantissa_.is_negative_ = false;
+    bool inexact;
+    std::strong_ordering to_half = std::strong_ordering::less;
+    if (count > digit_count(mantissa_)) {
+        inexact = sticky || !mantissa_.is_zero();
+        mantissa_ = 0;
+    } else {
+        size_t whole_limbs =
+            static_cast<size_t>(count / BigInteger::kCharsInDigits);
+        long long remainder = 0;
+        long long modulus = BigInteger::kBase_;
+        if (whole_limbs > 0) {
+            remainder = mantissa_.digits_[whole_limbs - 1];
+            for (size_t i = 0; i + 1 < whole_limbs; ++i) {
+                sticky |= mantissa_.digits_[i] != 0;
+            }
+            mantissa_ = BigInteger::digits_slice(mantissa_, whole_limbs,
+                                                 mantissa_.digits_.size());
+        }
+        if (count % BigInteger::kCharsInDigits != 0) {
+            sticky |= remainder != 0;
+            modulus = power_of_ten(count % BigInteger::kCharsInDigits);
+            remainder = mantissa_.divmod_small(modulus);
+        }
+        inexact = sticky || remainder != 0;
+        to_half = remainder <=> modulus / 2;
+        if (to_half == 0 && sticky) {
+            to_half = std::strong_ordering::greater;
+        }
+    }
+
+    bool round_up = false;
+    switch (precision_options.rounding) {
+        case RoundingMode::kNearestEven:
+            round_up = to_half > 0 ||
+                       (to_half == 0 && (mantissa_.digits_[0] & 1) != 0);
+            break;
+        case RoundingMode::kTowardZero:
+            break;
+        case RoundingMode::kDown:
+            round_up = inexact && is_negative;
+            break;
+        case RoundingMode::kUp:
+            round_up = inexact && !is_negative;
+            break;
+        case RoundingMode::kAwayFromZero:
+            round_up = inexact;
+            break;
+    }
+    if (round_up) {
+        mantissa_.add_small(1);
+    }
+    mantissa_.is_negative_ = is_negative && !mantissa_.is_zero();
+    exponent_ += count;
+    strip_zeros();
+}
+
+// A nonzero sticky means the exact value lies just above the magnitude of
+// the mantissa, so at least one digit has to be dropped to account for it.
+void BigFloat::round_to_precision(bool sticky) {
+    long long excess = digit_count(mantissa_) -
+                       static_cast<long long>(precision_options.precision);
+    if (sticky && excess <= 0) {
+        scale(mantissa_, 1 - excess);
+        exponent_ -= 1 - excess;
+        excess = 1;
+    }
+    round_off(excess, sticky);
+}
+
+// If rhs ends below the guard digits of the result, only its sign matters:
+// it is replaced by one unit past them, which rounds the same way in every
+// mode. Otherwise the mantissas are aligned and added exactly.
+void BigFloat::add(const BigFloat& rhs, bool subtract) {
+    BigInteger other = rhs.mantissa_;
+    long long other_exponent = rhs.exponent_;
+    if (subtract) {
+        other = -std::move(other);
+    }
+    if (other.is_zero()) {
+        round_to_precision(false);
+        return;
+    }
+    if (mantissa_.is_zero()) {
+        mantissa_ = std::move(other);
+        exponent_ = other_exponent;
+        round_to_precision(false);
+        return;
+    }
+    long long top = exponent_ + digit_count(mantissa_);
+    long long other_top = other_exponent + digit_count(other);
+    if (other_top > top) {
+        mantissa_.swap(other);
+        std::swap(exponent_, other_exponent);
+        std::swap(top, other_top);
+    }
+
+    long long width = std::max(static_cast<long long>(
+                                   precision_options.precision),
+                               digit_count(mantissa_));
+    long long guard = top - width - 2;
+    if (other_top <= guard) {
+        scale(mantissa_, exponent_ - guard + 1);
+        mantissa_.add_small(other.is_negative_ ? -1 : 1);
+        exponent_ = guard - 1;
+    } else {
+        if (exponent_ > other_exponent) {
+            scale(mantissa_, exponent_ - other_exponent);
+            exponent_ = other_exponent;
+        } else {
+            scale(other, other_exponent - exponent_);
+        }
+        mantissa_ += other;
+    }
+    round_to_precision(false);
+}
+
+// The dividend is scaled so that the quotient has at least precision + 1
+// digits, and the remainder becomes the sticky bit.
+void BigFloat::divide(BigInteger dividend, const BigInteger& divisor) {
+    long long shift = std::max(
+        0LL, static_cast<long long>(precision_options.precision) + 1 +
+                 digit_count(divisor) - digit_count(dividend));
+    scale(dividend, shift);
+    auto [quotient, remainder] = BigInteger::divmod(dividend, divisor);
+    mantissa_ = std::move(quotient);
+    exponent_ -= shift;
+    round_to_precision(!remainder.is_zero());
+}
+
+BigFloat::BigFloat(const Rational& number) {
+    if (number.denominator_ == 1) {
+        mantissa_ = number.numerator_;
+        round_to_precision(false);
+    } else if (!number.numerator_.is_zero()) {
+        divide(number.numerator_, number.denominator_);
+    }
+}
+
+BigFloat::BigFloat(const std::string& text) {
+    const char* first = text.data();
+    const char* last = first + text.size();
+    std::string digits;
+    if (first != last && *first == '-') {
+        digits.push_back(*first++);
+    }
+    long long fraction_digits = 0;
+    bool seen_point = false;
+    for (; first != last; ++first) {
+        if (std::isdigit(static_cast<unsigned char>(*first))) {
+            digits.push_back(*first);
+            fraction_digits += seen_point ? 1 : 0;
+        } else if (*first == '.' && !seen_point) {
+            seen_point = true;
+        } else {
+            break;
+        }
+    }
+    if (digits.empty() || digits == "-") {
+        throw std::invalid_argument("BigFloat: malformed number");
+    }
+    long long exponent = 0;
+    if (first != last && (*first == 'e' || *first == 'E')) {
+        ++first;
+        bool exponent_is_negative = first != last && *first == '-';
+        if (first != last && (*first == '-' || *first == '+')) {
+            ++first;
+        }
+        if (first == last) {
+            throw std::invalid_argument("BigFloat: malformed number");
+        }
+        // Half the range, so that subtracting the fraction digits below
+        // cannot overflow.
+        const long long kMaxExponent =
+            std::numeric_limits<long long>::max() / 2;
+        for (; first != last &&
+               std::isdigit(static_cast<unsigned char>(*first));
+             ++first) {
+            if (exponent > (kMaxExponent - (*first - '0')) / 10) {
+                throw std::out_of_range("BigFloat: exponent out of range");
+            }
+            exponent = exponent * 10 + (*first - '0');
+        }
+        if (exponent_is_negative) {
+            exponent = -exponent;
+        }
+    }
+    if (first != last) {
+        throw std::invalid_argument("BigFloat: malformed number");
+    }
+    BigInteger::from_chars(digits.data(), digits.data() + digits.size(),
+                           mantissa_);
+    exponent_ = exponent - fraction_digits;
+    round_to_precision(false);
+}
+
+BigFloat::operator Rational() const {
+    BigInteger power = 1;
+    if (exponent_ >= 0) {
+        BigInteger numerator = mantissa_;
+        scale(numerator, exponent_);
+        return Rational(numerator);
+    }
+    scale(power, -exponent_);
+    return Rational(mantissa_, power);
+}
+
+BigFloat& BigFloat::operator+=(const BigFloat& rhs) {
+    add(rhs, false);
+    return *this;
+}
+
+BigFloat& BigFloat::operator-=(const BigFloat& rhs) {
+    add(rhs, true);
+    return *this;
+}
+
+BigFloat& BigFloat::operator*=(const BigFloat& rhs) {
+    mantissa_ *= rhs.mantissa_;
+    exponent_ += rhs.exponent_;
+    round_to_precision(false);
+    return *this;
+}
+
+BigFloat& BigFloat::operator/=(const BigFloat& rhs) {
+    if (rhs.mantissa_.is_zero()) {
+        throw std::invalid_argument("BigFloat: division by zero");
+    }
+    exponent_ -= rhs.exponent_;
+    BigInteger dividend = std::move(mantissa_);
+    if (dividend.is_zero()) {
+        mantissa_ = 0;
+        exponent_ = 0;
+        return *this;
+    }
+    divide(std::move(dividend), rhs.mantissa_);
+    return *this;
+}
+
+BigFloat BigFloat::operator-() const& {
+    BigFloat result(*this);
+    return -std::move(result);
+}
+
+BigFloat BigFloat::operator-() && {
+    mantissa_ = -std::move(mantissa_);
+    return std::move(*this);
+}
+
+// The mantissa is scaled to at least 2 * precision + 2 digits with an even
+// exponent, so its integer square root has precision + 1 digits and the
+// remainder of the root becomes the sticky bit.
+BigFloat BigFloat::sqrt(const BigFloat& number) {
+    if (number.sign() < 0) {
+        throw std::invalid_argument("BigFloat: square root of a negative value");
+    }
+    BigFloat result;
+    if (number.sign() == 0) {
+        return result;
+    }
+    long long shift = std::max(
+        0LL, 2 * static_cast<long long>(precision_options.precision) + 2 -
+                 digit_count(number.mantissa_));
+    if ((number.exponent_ - shift) % 2 != 0) {
+        ++shift;
+    }
+    BigInteger scaled = number.mantissa_;
+    scale(scaled, shift);
+    result.mantissa_ = BigInteger::isqrt(scaled);
+    result.exponent_ = (number.exponent_ - shift) / 2;
+    bool sticky = result.mantissa_ * result.mantissa_ != scaled;
+    result.round_to_precision(sticky);
+    return result;
+}
+
+// Values of one sign are ordered by the position of their leading digit
+// first; mantissas are aligned only when it is the same.
+std::strong_ordering operator<=>(const BigFloat& lhs, const BigFloat& rhs) {
+    int lhs_sign = lhs.sign();
+    int rhs_sign = rhs.sign();
+    if (lhs_sign != rhs_sign || lhs_sign == 0) {
+        return lhs_sign <=> rhs_sign;
+    }
+    std::strong_ordering magnitude =
+        lhs.exponent_ + BigFloat::digit_count(lhs.mantissa_) <=>
+        rhs.exponent_ + BigFloat::digit_count(rhs.mantissa_);
+    if (magnitude != 0) {
+        return lhs_sign > 0 ? magnitude : 0 <=> magnitude;
+    }
+    BigInteger left = lhs.mantissa_;
+    BigInteger right = rhs.mantissa_;
+    if (lhs.exponent_ > rhs.exponent_) {
+        BigFloat::scale(left, lhs.exponent_ - rhs.exponent_);
+    } else {
+        BigFloat::scale(right, rhs.exponent_ - lhs.exponent_);
+    }
+    return left <=> right;
+}
+
+std::string BigFloat::toString() const {
+    if (mantissa_.is_zero()) {
+        return "0";
+    }
+    std::string digits = mantissa_.toString();
+    size_t sign_sz = mantissa_.is_negative_ ? 1 : 0;
+    long long point = exponent_ + static_cast<long long>(digits.size() -
+                                                         sign_sz);
+    if (point - 1 < -7 || point - 1 >= 21) {
+        if (digits.size() > sign_sz + 1) {
+            digits.insert(sign_sz + 1, 1, '.');
+        }
+        digits += point - 1 < 0 ? "e-" : "e+";
+        digits += std::to_string(std::abs(point - 1));
+    } else if (exponent_ >= 0) {
+        digits.append(static_cast<size_t>(exponent_), '0');
+    } else if (point > 0) {
+        digits.insert(sign_sz + static_cast<size_t>(point), 1, '.');
+    } else {
+        digits.insert(sign_sz, static_cast<size_t>(2 - point), '0');
+        digits[sign_sz + 1] = '.';
+    }
+    return digits;
+}
+
+std::string BigFloat::asDecimal(size_t precision) const {
+    BigFloat rounded(*this);
+    long long fraction_digits = static_cast<long long>(precision);
+    rounded.round_off(-fraction_digits - exponent_, false);
+
+    BigInteger magnitude = rounded.mantissa_;
+    magnitude.is_negative_ = false;
+    if (!magnitude.is_zero()) {
+        scale(magnitude, rounded.exponent_ + fraction_digits);
+    }
+    std::string digits = magnitude.toString();
+    if (digits.size() <= precision) {
+        digits.insert(0, precision + 1 - digits.size(), '0');
+    }
+    std::string result;
+    if (rounded.sign() < 0) {
+        result.push_back('-');
+    }
+    result.append(digits, 0, digits.size() - precision);
+    if (precision > 0) {
+        result.push_back('.');
+        result.append(digits, digits.size() - precision, precision);
+    }
+    return result;
+}
+
+std::istream& operator>>(std::istream& input, BigFloat& number) {
+    std::string text;
+    if (!(input >> text)) {
+        return input;
+    }
+    try {
+        number = BigFloat(text);
+    } catch (const std::invalid_argument&) {
+        input.setstate(std::ios::failbit);
+    }
+    return input;
+}
+
+std::ostream& operator<<(std::ostream& output, const BigFloat& number) {
+    output << number.toString();
+    return output;
+}
@@ -0,0 +1,363 @@
+// g++ -std=c++20 -O2 -pthread -I.. biginteger_test.cpp && ./a.out
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../biginteger.h"
+#include "../stackallocator.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        ++failures;
+        std::cerr << "FAILED: " << what << '\n';
+    }
+}
+
+template <typename Exception, typename Function>
+void check_throws(Function function, const char* what) {
+    try {
+        function();
+    } catch (const Exception&) {
+        return;
+    }
+    check(false, what);
+}
+
+std::mt19937_64 rng(2024);
+
+// A random number of exactly limbs base 10^18 limbs.
+BigInteger random_number(size_t limbs) {
+    std::string digits(1, static_cast<char>('1' + rng() % 9));
+    for (size_t i = 1; i < 18 * limbs; ++i) {
+        digits += static_cast<char>('0' + rng() % 10);
+    }
+    return BigInteger(digits);
+}
+
+void test_arena() {
+    BigInteger number = random_number(400);
+    BigInteger expected = number * number;
+    BigInteger result;
+    BigInteger::multiplication_thresholds.toom3 = 100;
+    BigInteger::parallel_options.threads = 4;
+    BigInteger::parallel_options.min_size = 16;
+    {
+        static StackStorage<(1 << 20)> storage;
+        BigInteger::ArenaScope scope{
+            StackAllocator<long long, (1 << 20)>(storage)};
+        BigInteger square = number * number;
+        BigInteger product = number * (number + 1);
+        result = square;
+        check(product - square == number, "arena: parallel product");
+    }
+    BigInteger::multiplication_thresholds = {};
+    BigInteger::parallel_options = {};
+    check(result == expected, "arena: result copied out of the scope");
+}
+
+void test_parsers() {
+    for (size_t limbs : {1, 2, 3, 50}) {
+        BigInteger number = -random_number(limbs);
+        std::string text = number.toString();
+        BigInteger parsed;
+        const char* end =
+            BigInteger::from_chars(text.data(), text.data() + text.size(),
+                                   parsed);
+        check(end == text.data() + text.size() && parsed == number,
+              "from_chars: round trip");
+        std::istringstream input(text);
+        input >> parsed;
+        check(!input.fail() && parsed == number, "operator>>: round trip");
+    }
+
+    std::vector<BigInteger> values;
+    std::string text = " 12\n-3\t4 ";
+    check(BigInteger::read_batch(text.data(), text.data() + text.size(),
+                                 values) == 3 &&
+              values[0] == 12 && values[1] == -3 && values[2] == 4,
+          "read_batch: buffer");
+    std::istringstream batch(text);
+    check(BigInteger::read_batch(batch, values) == 3 && values[2] == 4,
+          "read_batch: stream");
+
+    for (std::string malformed : {"12-3 4", "1 x 2", "7 -", "5a"}) {
+        check_throws<std::invalid_argument>(
+            [&] {
+                BigInteger::read_batch(
+                    malformed.data(), malformed.data() + malformed.size(),
+                    values);
+            },
+            "read_batch: malformed buffer");
+        std::istringstream input(malformed);
+        BigInteger::read_batch(input, values);
+        check(input.fail(), "read_batch: malformed stream sets failbit");
+    }
+    std::istringstream glued("12-3 4");
+    check(BigInteger::read_batch(glued, values) == 0 && glued.fail(),
+          "read_batch: number glued to the next one");
+
+    Rational rational;
+    std::string fraction = "-6/4";
+    Rational::from_chars(fraction.data(), fraction.data() + fraction.size(),
+                         rational);
+    check(rational == Rational(BigInteger(-3), BigInteger(2)),
+          "Rational::from_chars: reduces");
+    std::string zero = "3/0";
+    check_throws<std::invalid_argument>(
+        [&] {
+            Rational::from_chars(zero.data(), zero.data() + zero.size(),
+                                 rational);
+        },
+        "Rational::from_chars: zero denominator");
+    std::istringstream zero_input(zero);
+    zero_input >> rational;
+    check(zero_input.fail(), "Rational operator>>: zero denominator");
+}
+
+std::string to_binary(const BigInteger& value) {
+    std::string bytes(value.binary_size(), '\0');
+    value.to_binary(bytes.data());
+    return bytes;
+}
+
+void test_binary() {
+    std::vector<BigInteger> numbers = {0, -1, random_number(1),
+                                       -random_number(7), random_number(300)};
+    for (const BigInteger& number : numbers) {
+        std::string bytes = to_binary(number);
+        BigInteger loaded;
+        check(BigInteger::from_binary(bytes.data(), bytes.data() + bytes.size(),
+                                      loaded) == bytes.data() + bytes.size() &&
+                  loaded == number,
+              "binary: buffer round trip");
+        std::istringstream input(bytes);
+        BigInteger::read_binary(input, loaded);
+        check(loaded == number, "binary: stream round trip");
+    }
+
+    std::ostringstream array_output;
+    BigInteger::write_binary(array_output, numbers);
+    std::string array_bytes = array_output.str();
+    std::vector<BigInteger> loaded_numbers;
+    BigInteger::read_binary(array_bytes.data(),
+                            array_bytes.data() + array_bytes.size(),
+                            loaded_numbers);
+    check(loaded_numbers == numbers, "binary: buffer array round trip");
+    std::istringstream array_input(array_bytes);
+    loaded_numbers.clear();
+    BigInteger::read_binary(array_input, loaded_numbers);
+    check(loaded_numbers == numbers, "binary: stream array round trip");
+
+    std::vector<Rational> fractions = {
+        Rational(0), Rational(BigInteger(-7), BigInteger(3)),
+        Rational(random_number(20), random_number(30))};
+    std::ostringstream fraction_output;
+    Rational::write_binary(fraction_output, fractions);
+    std::string fraction_bytes = fraction_output.str();
+    std::vector<Rational> loaded_fractions;
+    Rational::read_binary(fraction_bytes.data(),
+                          fraction_bytes.data() + fraction_bytes.size(),
+                          loaded_fractions);
+    check(loaded_fractions == fractions, "binary: Rational round trip");
+
+    // A limb out of range, a leading zero limb, a negative zero, a count
+    // past the end and a truncated limb.
+    std::string two_limbs = to_binary(random_number(2));
+    std::string out_of_range = two_limbs;
+    out_of_range[15] = '\x7f';
+    std::string leading_zero = two_limbs;
+    std::fill(leading_zero.begin() + 16, leading_zero.end(), '\0');
+    std::string negative_zero = to_binary(0);
+    negative_zero[0] |= 1;
+    std::string forged_count = two_limbs;
+    forged_count[7] = '\x10';
+    std::string truncated = two_limbs.substr(0, 20);
+    const BigInteger kept = 42;
+    for (const std::string& malformed :
+         {out_of_range, leading_zero, negative_zero, forged_count, truncated}) {
+        BigInteger value = kept;
+        check_throws<std::invalid_argument>(
+            [&] {
+                BigInteger::from_binary(malformed.data(),
+                                        malformed.data() + malformed.size(),
+                                        value);
+            },
+            "binary: malformed buffer value");
+        std::istringstream input(malformed);
+        check_throws<std::invalid_argument>(
+            [&] { BigInteger::read_binary(input, value); },
+            "binary: malformed stream value");
+        check(value == kept, "binary: malformed value leaves the target");
+    }
+
+    std::string bad_magic = array_bytes;
+    bad_magic[0] = 'X';
+    check_throws<std::invalid_argument>(
+        [&] {
+            BigInteger::read_binary(bad_magic.data(),
+                                    bad_magic.data() + bad_magic.size(),
+                                    loaded_numbers);
+        },
+        "binary: bad array magic");
+    check_throws<std::invalid_argument>(
+        [&] {
+            Rational::read_binary(array_bytes.data(),
+                                  array_bytes.data() + array_bytes.size(),
+                                  loaded_fractions);
+        },
+        "binary: array of another kind");
+
+    for (const BigInteger& denominator : {BigInteger(0), BigInteger(-2)}) {
+        std::string malformed = to_binary(5) + to_binary(denominator);
+        Rational value = Rational(BigInteger(1), BigInteger(3));
+        check_throws<std::invalid_argument>(
+            [&] {
+                Rational::from_binary(malformed.data(),
+                                      malformed.data() + malformed.size(),
+                                      value);
+            },
+            "binary: Rational denominator in a buffer");
+        std::istringstream input(malformed);
+        check_throws<std::invalid_argument>(
+            [&] { Rational::read_binary(input, value); },
+            "binary: Rational denominator in a stream");
+        check(value == Rational(BigInteger(1), BigInteger(3)),
+              "binary: malformed Rational leaves the target");
+    }
+}
+
+static_assert(FixedBigInt<128>(-3) * FixedBigInt<128>(7) == -21);
+
+// Products wrap modulo 2^Bits into [-2^(Bits - 1), 2^(Bits - 1)).
+template <size_t Bits>
+void test_fixed_multiplication() {
+    BigInteger modulus = 1;
+    for (size_t i = 0; i < Bits; ++i) {
+        modulus *= 2;
+    }
+    BigInteger half = modulus / 2;
+    for (int round = 0; round < 200; ++round) {
+        BigInteger lhs = random_number(1 + rng() % (Bits / 50));
+        BigInteger rhs = random_number(1 + rng() % (Bits / 50));
+        if (rng() % 2) {
+            lhs = -lhs;
+        }
+        BigInteger expected = lhs * rhs % modulus;
+        if (expected < 0) {
+            expected += modulus;
+        }
+        if (expected >= half) {
+            expected -= modulus;
+        }
+        BigInteger product(FixedBigInt<Bits>(lhs) * FixedBigInt<Bits>(rhs));
+        check(product == expected, "FixedBigInt: product");
+    }
+}
+
+void test_float_parsing() {
+    check(BigFloat("-12.5e-3") == BigFloat(Rational(BigInteger(-1), 80)),
+          "BigFloat: parses a fraction with an exponent");
+    check(BigFloat("1e4611686018427387903") > BigFloat("1e100"),
+          "BigFloat: largest exponent");
+    for (const char* text : {"1e99999999999999999999", "1e-4611686018427387904",
+                             "0.5e9223372036854775807"}) {
+        check_throws<std::out_of_range>([&] { BigFloat number(text); },
+                                        "BigFloat: exponent overflow");
+    }
+    for (const char* text : {"", "-", "1e", "1.2.3", "1e+-2", "12a"}) {
+        check_throws<std::invalid_argument>([&] { BigFloat number(text); },
+                                            "BigFloat: malformed number");
+    }
+}
+
+BigInteger magnitude(const BigInteger& value) {
+    return value < 0 ? -value : value;
+}
+
+// Divisors below two limbs use divmod_small, then Knuth D up to 1500 limbs
+// and Newton division above.
+void test_division() {
+    for (size_t divisor_limbs : {1, 2, 40, 1499, 1500, 1700}) {
+        for (size_t extra_limbs : {0, 1, 30, 1800}) {
+            BigInteger divisor = random_number(divisor_limbs);
+            BigInteger quotient = random_number(extra_limbs + 1);
+            BigInteger exact = quotient * divisor;
+            std::vector<BigInteger> dividends = {exact, exact - 1, exact + 1,
+                                                 -(exact + divisor - 1)};
+            for (const BigInteger& dividend : dividends) {
+                auto [q, r] = BigInteger::divmod(dividend, divisor);
+                check(q * divisor + r == dividend && magnitude(r) < divisor &&
+                          (r == 0 || (r < 0) == (dividend < 0)),
+                      "divmod: identity");
+                check(dividend / -divisor == -q && dividend % -divisor == r,
+                      "divmod: negative divisor");
+            }
+            check(BigInteger::divmod(exact, divisor).first == quotient,
+                  "divmod: exact quotient");
+        }
+    }
+    check_throws<std::invalid_argument>(
+        [] { BigInteger::divmod(BigInteger(1), BigInteger(0)); },
+        "divmod: division by zero");
+}
+
+const size_t kNever = std::numeric_limits<size_t>::max();
+
+// Products and squares under the given thresholds against schoolbook
+// multiplication, including unbalanced operands and all-nines limbs.
+void check_multiplication(BigInteger::MultiplicationThresholds thresholds,
+                          const char* what) {
+    std::vector<BigInteger> operands;
+    for (size_t limbs : {1, 5, 9, 31, 64, 100, 257, 400}) {
+        operands.push_back(random_number(limbs));
+    }
+    operands.push_back(BigInteger(std::string(18 * 300, '9')));
+    operands.push_back(-BigInteger(std::string(18 * 90, '9')));
+    for (const BigInteger& lhs : operands) {
+        for (const BigInteger& rhs : operands) {
+            BigInteger::multiplication_thresholds = {kNever, kNever, kNever,
+                                                     kNever};
+            BigInteger expected = lhs * rhs;
+            BigInteger expected_square = lhs * lhs;
+            BigInteger::multiplication_thresholds = thresholds;
+            check(lhs * rhs == expected, what);
+            check(lhs * lhs == expected_square, what);
+        }
+    }
+    BigInteger::multiplication_thresholds = {};
+}
+
+void test_multiplication() {
+    check_multiplication({4, kNever, kNever, 8}, "multiply: NTT");
+    check_multiplication({4, 12, kNever, kNever}, "multiply: Toom-3");
+    check_multiplication({4, 12, 12, kNever}, "multiply: Toom-4");
+    check_multiplication({4, 12, 24, 300}, "multiply: all tiers");
+
+    BigInteger::parallel_options = {4, 8, 4};
+    check_multiplication({}, "multiply: parallel Karatsuba");
+    check_multiplication({4, 12, 24, 300}, "multiply: parallel tiers");
+    BigInteger::parallel_options = {};
+}
+
+}  // namespace
+
+int main() {
+    test_arena();
+    test_parsers();
+    test_binary();
+    test_fixed_multiplication<64>();
+    test_fixed_multiplication<256>();
+    test_fixed_multiplication<1024>();
+    test_float_parsing();
+    test_division();
+    test_multiplication();
+    if (failures == 0) {
+        std::cout << "OK\n";
+    }
+    return failures == 0 ? 0 : 1;
+}